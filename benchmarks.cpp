@@ -0,0 +1,256 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "params.hpp"
+#include "board.hpp"
+#include "fen.hpp"
+#include "move.hpp"
+#include "movegenerator.hpp"
+#include "eval.hpp"
+#include "zobrist.hpp"
+#include "magics.hpp"
+
+using namespace std::chrono;
+
+// globals of the engine, defined by the main executable otherwise
+TTentry	tTable[ttsize];
+int movetime;
+high_resolution_clock::time_point start;
+
+/******************************************************************************
+ * Microbenchmarks of the single kernels of the engine (build with
+ * 'make benchmarks', run bin/azalea_bench [--csv] [--runs <n>]).
+ *
+ * Every kernel is timed in several runs over a fixed set of positions (the
+ * perft test positions), a run is repeated often enough to take a few
+ * milliseconds. Reported are the mean, the standard deviation and the minimum
+ * of the nanoseconds per operation over all runs, with '--csv' as one line per
+ * kernel.
+ */
+static const std::vector<std::string> positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2rQ4/7B/nN2bK1N/8/r7/1k6/3n2q1/4B2R w - - 0 1",
+    "2r5/4N3/2b5/1k6/4n3/8/8/4K1B1 w - - 0 1",
+    "8/8/1KP2r2/2N2k2/8/5b2/4p3/3N4 w - - 0 1",
+    "r3k2r/8/8/4n3/4N3/8/8/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/p7/8/8/8/8/7P/RNBQKBNR w KQkq - 0 1",
+    "3r1k2/4p3/8/3P4/8/8/3K4/8 w - - 0 1",
+};
+
+struct BenchResult {
+    std::string name;
+    unsigned long long int ops; // operations per run
+    double mean;   // ns/op
+    double stddev; // ns/op
+    double min;    // ns/op
+};
+
+// keeps the results of the kernels from being optimized away
+static volatile uint64_t sink;
+
+/******************************************************************************
+ * Times 'pass' (one pass over all positions, returns the number of
+ * operations done) in 'runs' runs of at least 'minRunNs' nanoseconds each.
+ */
+template <typename Pass>
+static BenchResult measure(const std::string& name, const int runs,
+						    Pass pass) {
+    constexpr long long int minRunNs = 20'000'000;
+
+    // warm up and find the number of passes per run
+    auto t0 = steady_clock::now();
+    pass();
+    auto t1 = steady_clock::now();
+    const long long int passNs = duration_cast<nanoseconds>(t1-t0).count();
+    const long long int passes = std::max(1LL, minRunNs / (passNs + 1));
+
+    std::vector<double> nsPerOp;
+    unsigned long long int ops = 0;
+    for (int run=0; run<runs; run++) {
+	ops = 0;
+	t0 = steady_clock::now();
+	for (long long int i=0; i<passes; i++) ops += pass();
+	t1 = steady_clock::now();
+	const auto ns = duration_cast<nanoseconds>(t1-t0).count();
+	nsPerOp.push_back((double)ns / (double)ops);
+    }
+
+    double mean = 0.0;
+    for (const auto x: nsPerOp) mean += x;
+    mean /= nsPerOp.size();
+    double var = 0.0;
+    for (const auto x: nsPerOp) var += (x - mean) * (x - mean);
+    var /= std::max(1, (int)nsPerOp.size() - 1);
+
+    return {name, ops, mean, std::sqrt(var),
+	    *std::min_element(nsPerOp.begin(), nsPerOp.end())};
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = false;
+    int runs = 10;
+    for (int i=1; i<argc; i++) {
+	const std::string arg = argv[i];
+	if (arg == "--csv") {
+	    csv = true;
+	} else if (arg == "--runs" and i+1 < argc) {
+	    runs = std::max(2, std::stoi(argv[++i]));
+	} else {
+	    std::cerr << "usage: " << argv[0] << " [--csv] [--runs <n>]\n";
+	    return 1;
+	}
+    }
+
+    const zobristKeys zobrist = initZobrist();
+    initMagics();
+    sliderBackend = detectSliderBackend();
+
+    std::vector<GameState> states;
+    for (const auto& f: positions) states.push_back(fen(f, zobrist));
+
+    // legal moves of every position, for make/unmake
+    std::vector<MoveList> moves(states.size());
+    for (size_t i=0; i<states.size(); i++) {
+	bool inCheck;
+	generateLegalMoves(states[i], moves[i], inCheck);
+    }
+
+    std::vector<BenchResult> results;
+
+    results.push_back(measure("generateLegalMoves", runs, [&]() {
+	unsigned long long int ops = 0;
+	for (const auto& gs: states) {
+	    MoveList ml;
+	    bool inCheck;
+	    generateLegalMoves(gs, ml, inCheck);
+	    sink = sink + ml.size();
+	    ops++;
+	}
+	return ops;
+    }));
+
+    results.push_back(measure("generateKingDanger", runs, [&]() {
+	unsigned long long int ops = 0;
+	for (const auto& gs: states) {
+	    sink = sink ^ generateKingDanger(gs);
+	    ops++;
+	}
+	return ops;
+    }));
+
+    results.push_back(measure("rookAttacks", runs, [&]() {
+	unsigned long long int ops = 0;
+	bitb acc = 0x0ULL;
+	for (const auto& gs: states) {
+	    for (int sq=0; sq<64; sq++) acc ^= rookAttacks(gs.board.occ, sq);
+	    ops += 64;
+	}
+	sink = sink ^ acc;
+	return ops;
+    }));
+
+    results.push_back(measure("bishopAttacks", runs, [&]() {
+	unsigned long long int ops = 0;
+	bitb acc = 0x0ULL;
+	for (const auto& gs: states) {
+	    for (int sq=0; sq<64; sq++) acc ^= bishopAttacks(gs.board.occ, sq);
+	    ops += 64;
+	}
+	sink = sink ^ acc;
+	return ops;
+    }));
+
+    // both make/unmake schemes, the search uses the one of 'azalea::copyMake'
+    const auto makeUnmake = [&]<bool copy>() {
+	unsigned long long int ops = 0;
+	for (size_t i=0; i<states.size(); i++) {
+	    GameState& gs = states[i];
+	    for (const auto& m: moves[i]) {
+		const auto undo = gs.doMove<copy>(m, zobrist);
+		sink = sink ^ gs.zhash;
+		gs.undoMove<copy>(undo);
+		ops++;
+	    }
+	}
+	return ops;
+    };
+    results.push_back(measure("makeMove+unmakeMove", runs, [&]() {
+	return makeUnmake.template operator()<false>();
+    }));
+    results.push_back(measure("copyMake+restore", runs, [&]() {
+	return makeUnmake.template operator()<true>();
+    }));
+
+    results.push_back(measure("eval", runs, [&]() {
+	unsigned long long int ops = 0;
+	for (const auto& gs: states) {
+	    sink = sink + eval<false>(gs);
+	    ops++;
+	}
+	return ops;
+    }));
+
+    // keys of all children, spread over the whole table
+    std::vector<uint64_t> keys;
+    for (size_t i=0; i<states.size(); i++) {
+	for (const auto& m: moves[i]) {
+	    const auto umi = states[i].makeMove(m, zobrist);
+	    keys.push_back(states[i].zhash);
+	    states[i].unmakeMove(umi);
+	}
+    }
+
+    results.push_back(measure("ttStore", runs, [&]() {
+	for (const auto key: keys) {
+	    TTentry entry;
+	    entry.zhash = key;
+	    entry.draft = (int)(key & 0xf);
+	    entry.score = 0;
+	    entry.nodeType = NodeType::PVNode;
+	    tTable[key%ttsize] = entry;
+	}
+	return (unsigned long long int)keys.size();
+    }));
+
+    results.push_back(measure("ttProbe", runs, [&]() {
+	unsigned long long int hits = 0;
+	for (const auto key: keys) {
+	    const auto entry = tTable[key%ttsize];
+	    if (entry.zhash == key) hits += entry.draft;
+	}
+	sink = sink + hits;
+	return (unsigned long long int)keys.size();
+    }));
+
+    if (csv) {
+	std::cout << "kernel,ops,mean_ns,stddev_ns,min_ns\n";
+	for (const auto& r: results) {
+	    std::cout << r.name << "," << r.ops << "," << r.mean << ","
+		      << r.stddev << "," << r.min << "\n";
+	}
+    } else {
+	std::cout << "slider backend: " << toString(sliderBackend)
+		  << ", fill backend: " << toString(fillBackend)
+		  << ", runs: " << runs << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for (const auto& r: results) {
+	    std::cout << "  " << std::left << std::setw(22) << r.name
+		      << std::right << std::setw(10) << r.mean << " ns/op"
+		      << "  +- " << std::setw(7) << r.stddev
+		      << "  min " << std::setw(10) << r.min << "\n";
+	}
+    }
+    std::cout << std::flush;
+
+    return 0;
+}
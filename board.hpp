@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "params.hpp"
 #include "move.hpp"
 #include "zobrist.hpp"
@@ -31,53 +33,102 @@
 /******************************************************************************
  * Board class
  *
- * Using bitboards...
+ * Using bitboards, one per piece type (indexed by 'pieceIndex') and one per
+ * color (0 for white, 1 for black), the pieces of one kind are the AND of
+ * both. Plus a mailbox with the piece type on every square, so the piece on a
+ * given square is found without testing the bitboards.
+ *
+ * The named accessors (wPawns() ... bKing(), white(), black()) are kept from
+ * the old layout with twelve separate bitboards.
  */
 class Board {
 public:
-    // white pieces
-    bitb wPawns;
-    bitb wKnights;
-    bitb wBishops;
-    bitb wRooks;
-    bitb wQueens;
-    bitb wKing;
-
-    // black pieces
-    bitb bPawns;
-    bitb bKnights;
-    bitb bBishops;
-    bitb bRooks;
-    bitb bQueens;
-    bitb bKing;
-
-    // color and occupancy
-    bitb white;
-    bitb black;
+    bitb pieces[6]; // both colors, by piece type
+    bitb colors[2]; // all pieces of white and black
     bitb occ;
 
-    Board() :
-	wPawns(0), wKnights(0), wBishops(0), wRooks(0), wQueens(0), wKing(0),
-	bPawns(0), bKnights(0), bBishops(0), bRooks(0), bQueens(0), bKing(0),
-	white(0), black(0), occ(0)
-	{}
+    // piece type on every square
+    pieceType squares[64];
+
+    Board() : pieces{}, colors{}, occ(0) { fillSquares(); }
 
     Board(bitb wp, bitb wn, bitb wb, bitb wr, bitb wq, bitb wk,
 	  bitb bp, bitb bn, bitb bb, bitb br, bitb bq, bitb bk) :
-	wPawns(wp), wKnights(wn), wBishops(wb),
-	wRooks(wr), wQueens(wq), wKing(wk),
-	bPawns(bp), bKnights(bn), bBishops(bb),
-	bRooks(br), bQueens(bq), bKing(bk),
-	white(wp|wk|wb|wr|wq|wk), black(bp|bk|bb|br|bq|bk), occ(white|black)
-	{}
+	pieces{wp|bp, wn|bn, wb|bb, wr|br, wq|bq, wk|bk},
+	colors{wp|wn|wb|wr|wq|wk, bp|bn|bb|br|bq|bk},
+	occ(colors[0]|colors[1])
+	{ fillSquares(); }
+
+    // pieces of type 'p' and color 'color'
+    bitb get(const int color, const pieceType p) const {
+	return pieces[pieceIndex(p)] & colors[color];
+    }
+
+    bitb wPawns() const { return pieces[0] & colors[0]; }
+    bitb wKnights() const { return pieces[1] & colors[0]; }
+    bitb wBishops() const { return pieces[2] & colors[0]; }
+    bitb wRooks() const { return pieces[3] & colors[0]; }
+    bitb wQueens() const { return pieces[4] & colors[0]; }
+    bitb wKing() const { return pieces[5] & colors[0]; }
+    bitb bPawns() const { return pieces[0] & colors[1]; }
+    bitb bKnights() const { return pieces[1] & colors[1]; }
+    bitb bBishops() const { return pieces[2] & colors[1]; }
+    bitb bRooks() const { return pieces[3] & colors[1]; }
+    bitb bQueens() const { return pieces[4] & colors[1]; }
+    bitb bKing() const { return pieces[5] & colors[1]; }
+    bitb white() const { return colors[0]; }
+    bitb black() const { return colors[1]; }
+
+    // puts a piece of type 'p' and color 'color' on the empty square 'sq'
+    void addPiece(const int color, const pieceType p, const int sq) {
+	const bitb mask = (1ULL << sq);
+	pieces[pieceIndex(p)] |= mask;
+	colors[color] |= mask;
+	occ |= mask;
+	squares[sq] = p;
+    }
+
+    // removes the piece of type 'p' and color 'color' from the square 'sq'
+    void removePiece(const int color, const pieceType p, const int sq) {
+	const bitb mask = (1ULL << sq);
+	pieces[pieceIndex(p)] ^= mask;
+	colors[color] ^= mask;
+	occ ^= mask;
+	squares[sq] = pieceType::none;
+    }
+
+    // moves a piece from 'from' to the empty square 'to'
+    void movePiece(const int color, const pieceType p, const int from,
+							    const int to) {
+	const bitb mask = (1ULL << from) | (1ULL << to);
+	pieces[pieceIndex(p)] ^= mask;
+	colors[color] ^= mask;
+	occ ^= mask;
+	squares[from] = pieceType::none;
+	squares[to] = p;
+    }
+
+    // rebuilds the mailbox from the bitboards
+    void fillSquares() {
+	for (int sq=0; sq<64; sq++) squares[sq] = pieceType::none;
+	for (int i=0; i<6; i++) {
+	    bitb bb = pieces[i];
+	    while (bb) {
+		squares[BSF(bb)] = static_cast<pieceType>(i + 1);
+		bb &= bb - 1;
+	    }
+	}
+    }
 };
 
 /******************************************************************************
- * Game state class
+ * Position class
  *
- * Contains the board state and additional stuff like castling rights.
+ * The compact part of the game state: board, side to move, castling rights,
+ * en passant target, halfmove clock and hash, without any history. Copied
+ * once per ply by the copy-make scheme (see 'azalea::copyMake').
  */
-class GameState {
+class Position {
 public:
     Board board;
     bool whiteToMove;
@@ -90,13 +141,57 @@ public:
 
     // zobrist hash of board state
     uint64_t zhash;
+    // zobrist hash of the pawns only and of the material (the number of
+    // pieces of every kind, see 'zobristKeys::material')
+    uint64_t pawnKey;
+    uint64_t materialKey;
+
+    // running sums of material and square values (white's view) for the
+    // early and late game and the game phase, see eval.hpp
+    int earlySum;
+    int lateSum;
+    int phase;
+};
 
-    // array of zorist hash to track history for repetition detection
-    uint64_t repHist[azalea::repHistMaxPly];
-    int repPlyCounter = 0;
-
+/******************************************************************************
+ * Game state class
+ *
+ * The position with the moves to change it. The repetition history is kept
+ * apart from it (see history.hpp).
+ */
+class GameState : public Position {
+public:
     UnmakeInfo makeMove(const Move& m, const zobristKeys& zobrist);
-    void unmakeMove(UnmakeInfo umi, const zobristKeys& zobrist);
+    void unmakeMove(const UnmakeInfo& umi);
+
+    // passes the turn: flips the side to move and clears the ep target,
+    // nothing on the board changes
+    NullUnmakeInfo makeNullMove(const zobristKeys& zobrist);
+    void unmakeNullMove(const NullUnmakeInfo& numi);
+
+    // makes and takes back the move by the scheme chosen at build time,
+    // 'doMove' returns the position before the move with copy-make (restored
+    // by 'undoMove', 'unmakeMove' never runs) and the unmake info otherwise
+    template <bool copy = azalea::copyMake>
+    std::conditional_t<copy, Position, UnmakeInfo> doMove(const Move& m,
+					    const zobristKeys& zobrist) {
+	if constexpr (copy) {
+	    const Position before = *this;
+	    makeMove(m, zobrist);
+	    return before;
+	} else {
+	    return makeMove(m, zobrist);
+	}
+    }
+
+    template <bool copy = azalea::copyMake>
+    void undoMove(const std::conditional_t<copy, Position, UnmakeInfo>& undo) {
+	if constexpr (copy) {
+	    static_cast<Position&>(*this) = undo;
+	} else {
+	    unmakeMove(undo);
+	}
+    }
 };
 
 // arrays to keep track of the different diagonals and antidiagonals
@@ -121,20 +216,28 @@ constexpr int antidiags[64] = { 0,  1,  2,  3,  4,  5,  6,  7,
 // perft function with bulk counting, no div
 unsigned long long int perft(GameState& gs, int depth, const zobristKeys& zobrist);
 void perftdiv(const GameState& gs, int depth, const zobristKeys& zobrist);
+// perft benchmark over all slider backends
+void bench(const zobristKeys& zobrist);
+// null move hash consistency test, returns the number of errors
+unsigned long long int nullMoveTest(GameState& gs, int depth,
+					const zobristKeys& zobrist);
+// givesCheck consistency test, returns the number of errors
+unsigned long long int givesCheckTest(const zobristKeys& zobrist);
 
 
 
 // tt test section
-enum class NodeType {
+enum class NodeType : uint8_t {
     AlphaNode, BetaNode, PVNode
 };
 
+// ordered by size, so that the entry packs into 24 bytes
 struct TTentry {
-    Move bestmove;
+    uint64_t zhash;
     int draft = -1;
     int score;
+    Move bestmove;
     NodeType nodeType;
-    uint64_t zhash;
 };
 // end of tt test section
 //
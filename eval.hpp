@@ -1,6 +1,9 @@
+#pragma once
+
 #include "board.hpp"
 #include "params.hpp"
 
+#include <array>
 #include <iostream>
 
 constexpr double F = 0.05;
@@ -106,133 +109,126 @@ constexpr int lateQueenSq[64] = {    0,    0,   30,   50,   50,   30,   0,   0,
 			             0,   30,   50,  150,  150,   50,  30,   0,
 			             0,    0,   30,   50,   50,   30,   0,   0};
 
-template <bool lprint>
-int eval(const GameState& gs) {
-    int earlyEval = 100; // start with small bonus for the tempo you have
-    int lateEval = 0;
-
-    int earlyMatEval = 0;
-    int earlyPosEval = 0;
-    int lateMatEval = 0;
-    int latePosEval = 0;
-
-    const Board& b = gs.board;
-
-    const int nwp = POP(b.wPawns);
-    const int nwn = POP(b.wKnights);
-    const int nwb = POP(b.wBishops);
-    const int nwr = POP(b.wRooks);
-    const int nwq = POP(b.wQueens);
-    const int nbp = POP(b.bPawns);
-    const int nbn = POP(b.bKnights);
-    const int nbb = POP(b.bBishops);
-    const int nbr = POP(b.bRooks);
-    const int nbq = POP(b.bQueens);
-
-    earlyMatEval += (nwp - nbp) * earlyValPawn;
-    earlyMatEval += (nwn - nbn) * earlyValKnight;
-    earlyMatEval += (nwb - nbb) * earlyValBishop;
-    earlyMatEval += (nwr - nbr) * earlyValRook;
-    earlyMatEval += (nwq - nbq) * earlyValQueen;
-
-    lateMatEval += (nwp - nbp) * lateValPawn;
-    lateMatEval += (nwn - nbn) * lateValKnight;
-    lateMatEval += (nwb - nbb) * lateValBishop;
-    lateMatEval += (nwr - nbr) * lateValRook;
-    lateMatEval += (nwq - nbq) * lateValQueen;
-
-    earlyEval += earlyMatEval;
-    lateEval += lateMatEval;
-
-    // calculate game phase
-    const int phase = (nwp + nbp) * pawnPhase
-		    + (nwn + nbn) * knightPhase
-		    + (nwb + nbb) * bishopPhase
-		    + (nwr + nbr) * rookPhase
-		    + (nwq + nbq) * queenPhase;
-
-    // square specific pawn value
-    bitb wp = b.wPawns;
-    while (wp) {
-	const int index = BSF(wp); wp &= wp - 1;
-	earlyPosEval += earlyPawnSq[index];
-	latePosEval += latePawnSq[index];
-    }
-    bitb bp = b.bPawns;
-    while (bp) {
-	const int index = BSF(bp); bp &= bp - 1;
-	earlyPosEval -= earlyPawnSq[index^56];
-	latePosEval -= latePawnSq[index^56];
+// values indexed by piece type (pawn to king, see 'pieceIndex'), the kings
+// have no material value and the queens no square value in the early game
+constexpr int earlyVal[6] = {earlyValPawn, earlyValKnight, earlyValBishop,
+			     earlyValRook, earlyValQueen, 0};
+constexpr int lateVal[6] = {lateValPawn, lateValKnight, lateValBishop,
+			    lateValRook, lateValQueen, 0};
+constexpr int phaseVal[6] = {pawnPhase, knightPhase, bishopPhase,
+			     rookPhase, queenPhase, 0};
+constexpr int noSq[64] = {};
+constexpr const int* earlySq[6] = {earlyPawnSq, knightSq, bishopSq,
+				   rookSq, noSq, earlyKingSq};
+constexpr const int* lateSq[6] = {latePawnSq, knightSq, bishopSq,
+				  rookSq, lateQueenSq, lateKingSq};
+
+/******************************************************************************
+ * Material plus square value of a piece by color, piece type and square, for
+ * the early and the late game. From white's view: black pieces count negative
+ * and use the mirrored squares.
+ */
+typedef std::array<std::array<std::array<int, 64>, 6>, 2> PieceSquareTable;
+
+constexpr PieceSquareTable makePieceSquareTable(const int (&val)[6],
+					    const int* const (&sq)[6]) {
+    PieceSquareTable table{};
+    for (int p=0; p<6; p++) {
+	for (int index=0; index<64; index++) {
+	    table[0][p][index] = val[p] + sq[p][index];
+	    table[1][p][index] = -(val[p] + sq[p][index^56]);
+	}
     }
+    return table;
+}
 
-    // square specific knight value
-    bitb wn = b.wKnights;
-    while (wn) {
-	const int index = BSF(wn); wn &= wn - 1;
-	earlyPosEval += knightSq[index];
-	latePosEval += knightSq[index];
-    }
-    bitb bn = b.bKnights;
-    while (bn) {
-	const int index = BSF(bn); bn &= bn - 1;
-	earlyPosEval -= knightSq[index^56];
-	latePosEval -= knightSq[index^56];
-    }
+constexpr PieceSquareTable earlyPieceSquare
+				= makePieceSquareTable(earlyVal, earlySq);
+constexpr PieceSquareTable latePieceSquare
+				= makePieceSquareTable(lateVal, lateSq);
+
+/******************************************************************************
+ * Running sums of the evaluation (see Position), updated by makeMove for
+ * every piece that enters or leaves a square (unmakeMove restores them).
+ */
+inline void evalAddPiece(Position& pos, const int color, const pieceType p,
+							    const int sq) {
+    const int i = pieceIndex(p);
+    pos.earlySum += earlyPieceSquare[color][i][sq];
+    pos.lateSum += latePieceSquare[color][i][sq];
+    pos.phase += phaseVal[i];
+}
 
-    // square specific bishop value
-    bitb wb = b.wBishops;
-    while (wb) {
-	const int index = BSF(wb); wb &= wb - 1;
-	earlyPosEval += bishopSq[index];
-	latePosEval += bishopSq[index];
-    }
-    bitb bb = b.bBishops;
-    while (bb) {
-	const int index = BSF(bb); bb &= bb - 1;
-	earlyPosEval -= bishopSq[index^56];
-	latePosEval -= bishopSq[index^56];
-    }
+inline void evalRemovePiece(Position& pos, const int color,
+				const pieceType p, const int sq) {
+    const int i = pieceIndex(p);
+    pos.earlySum -= earlyPieceSquare[color][i][sq];
+    pos.lateSum -= latePieceSquare[color][i][sq];
+    pos.phase -= phaseVal[i];
+}
 
-    // square specific rook value
-    bitb wr = b.wRooks;
-    while (wr) {
-	const int index = BSF(wr); wr &= wr - 1;
-	earlyPosEval += rookSq[index];
-	latePosEval += rookSq[index];
-    }
-    bitb br = b.bRooks;
-    while (br) {
-	const int index = BSF(br); br &= br - 1;
-	earlyPosEval -= rookSq[index^56];
-	latePosEval -= rookSq[index^56];
-    }
+inline void evalMovePiece(Position& pos, const int color, const pieceType p,
+					    const int from, const int to) {
+    const int i = pieceIndex(p);
+    pos.earlySum += earlyPieceSquare[color][i][to]
+		  - earlyPieceSquare[color][i][from];
+    pos.lateSum += latePieceSquare[color][i][to]
+		 - latePieceSquare[color][i][from];
+}
 
-    // square specific queen value
-    bitb wq = b.wQueens;
-    while (wq) {
-	const int index = BSF(wq); wq &= wq - 1;
-	latePosEval += lateQueenSq[index];
+// recomputes the running sums from the board
+inline void initEvalSums(Position& pos) {
+    pos.earlySum = 0;
+    pos.lateSum = 0;
+    pos.phase = 0;
+    for (int color=0; color<2; color++) {
+	for (int p=0; p<6; p++) {
+	    bitb pieces = pos.board.pieces[p] & pos.board.colors[color];
+	    while (pieces) {
+		const int index = BSF(pieces); pieces &= pieces - 1;
+		evalAddPiece(pos, color, static_cast<pieceType>(p + 1), index);
+	    }
+	}
     }
-    bitb bq = b.bQueens;
-    while (bq) {
-	const int index = BSF(bq); bq &= bq - 1;
-	latePosEval -= lateQueenSq[index^56];
-    }
-
-    // square specific king value
-    bitb wk = b.wKing;
-    earlyPosEval += earlyKingSq[BSF(wk)];
-    latePosEval += lateKingSq[BSF(wk)];
-    bitb bk = b.bKing;
-    earlyPosEval -= earlyKingSq[BSF(bk)^56];
-    latePosEval -= lateKingSq[BSF(bk)^56];
+}
 
-    earlyEval += earlyPosEval;
-    lateEval += latePosEval;
+template <bool lprint>
+int eval(const GameState& gs) {
+    // material and square values are kept up to date by makeMove
+    const int earlyEval = 100 + gs.earlySum; // small bonus for the tempo
+    const int lateEval = gs.lateSum;
+    const int phase = gs.phase;
 
     const int val = (phase * earlyEval)/startPhase
 		+ ((startPhase - phase) * lateEval)/startPhase;
-    if (lprint) {
+
+    if constexpr (lprint) {
+	// the breakdown is recomputed from the board
+	int earlyMatEval = 0;
+	int earlyPosEval = 0;
+	int lateMatEval = 0;
+	int latePosEval = 0;
+
+	const Board& b = gs.board;
+	for (int p=0; p<6; p++) {
+	    bitb white = b.pieces[p] & b.colors[0];
+	    bitb black = b.pieces[p] & b.colors[1];
+	    const int nw = POP(white);
+	    const int nb = POP(black);
+	    earlyMatEval += (nw - nb) * earlyVal[p];
+	    lateMatEval += (nw - nb) * lateVal[p];
+	    while (white) {
+		const int index = BSF(white); white &= white - 1;
+		earlyPosEval += earlySq[p][index];
+		latePosEval += lateSq[p][index];
+	    }
+	    while (black) {
+		const int index = BSF(black); black &= black - 1;
+		earlyPosEval -= earlySq[p][index^56];
+		latePosEval -= lateSq[p][index^56];
+	    }
+	}
+
         std::cout << " :: EVALUATION BREAKDOWN\n";
         std::cout << "early phase weight: "
         			<< (phase*100)/startPhase << "%\n";
@@ -249,4 +245,3 @@ int eval(const GameState& gs) {
     if (!gs.whiteToMove) return -val;
     return val;
 }
-
@@ -7,6 +7,7 @@
 #include "statistics.hpp"
 #include "board.hpp"
 #include "util.hpp"
+#include "eval.hpp"
 
 /******************************************************************************
  * Function that reads in a fen string and returns the corresponding board.
@@ -23,7 +24,8 @@ GameState fen(std::string f, const zobristKeys& zobrist) {
     gs.halfmoveClock = 0;
     gs.epTarget = -1;
     gs.zhash = 0ULL;
-    gs.repPlyCounter = 0;
+    gs.pawnKey = 0ULL;
+    gs.materialKey = 0ULL;
 
     auto it = f.begin();
 
@@ -33,62 +35,64 @@ GameState fen(std::string f, const zobristKeys& zobrist) {
 	const char c = *it;
 	switch (c) {
 	    case 'P':
-		gs.board.wPawns |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::pawn, index);
 		gs.zhash ^= zobrist.pieceSquare[0][0][index];
+		gs.pawnKey ^= zobrist.pieceSquare[0][0][index];
 		index--;
 		break;
 	    case 'N':
-		gs.board.wKnights |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::knight, index);
 		gs.zhash ^= zobrist.pieceSquare[0][1][index];
 		index--;
 		break;
 	    case 'B':
-		gs.board.wBishops |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::bishop, index);
 		gs.zhash ^= zobrist.pieceSquare[0][2][index];
 		index--;
 		break;
 	    case 'R':
-		gs.board.wRooks |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::rook, index);
 		gs.zhash ^= zobrist.pieceSquare[0][3][index];
 		index--;
 		break;
 	    case 'Q':
-		gs.board.wQueens |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::queen, index);
 		gs.zhash ^= zobrist.pieceSquare[0][4][index];
 		index--;
 		break;
 	    case 'K':
-		gs.board.wKing |= (1ULL << index);
+		gs.board.addPiece(0, pieceType::king, index);
 		gs.zhash ^= zobrist.pieceSquare[0][5][index];
 		index--;
 		break;
 	    case 'p':
-		gs.board.bPawns |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::pawn, index);
 		gs.zhash ^= zobrist.pieceSquare[1][0][index];
+		gs.pawnKey ^= zobrist.pieceSquare[1][0][index];
 		index--;
 		break;
 	    case 'n':
-		gs.board.bKnights |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::knight, index);
 		gs.zhash ^= zobrist.pieceSquare[1][1][index];
 		index--;
 		break;
 	    case 'b':
-		gs.board.bBishops |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::bishop, index);
 		gs.zhash ^= zobrist.pieceSquare[1][2][index];
 		index--;
 		break;
 	    case 'r':
-		gs.board.bRooks |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::rook, index);
 		gs.zhash ^= zobrist.pieceSquare[1][3][index];
 		index--;
 		break;
 	    case 'q':
-		gs.board.bQueens |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::queen, index);
 		gs.zhash ^= zobrist.pieceSquare[1][4][index];
 		index--;
 		break;
 	    case 'k':
-		gs.board.bKing |= (1ULL << index);
+		gs.board.addPiece(1, pieceType::king, index);
 		gs.zhash ^= zobrist.pieceSquare[1][5][index];
 		index--;
 		break;
@@ -179,11 +183,16 @@ GameState fen(std::string f, const zobristKeys& zobrist) {
 	gs.halfmoveClock += *it - '0';
     }
 
-    gs.board.white = gs.board.wPawns | gs.board.wKnights | gs.board.wBishops
-		    | gs.board.wRooks | gs.board.wQueens | gs.board.wKing;
-    gs.board.black = gs.board.bPawns | gs.board.bKnights | gs.board.bBishops
-		    | gs.board.bRooks | gs.board.bQueens | gs.board.bKing;
-    gs.board.occ = gs.board.white | gs.board.black;
+    // material key from the number of pieces of every kind
+    for (int c=0; c<2; c++) {
+	for (int i=0; i<6; i++) {
+	    const int n = POP(gs.board.pieces[i] & gs.board.colors[c]);
+	    for (int k=0; k<n; k++) gs.materialKey ^= zobrist.material[c][i][k];
+	}
+    }
+
+    // running sums of the evaluation
+    initEvalSums(gs);
 
     return gs;
 }
@@ -199,18 +208,18 @@ std::string toFen(const GameState& gs) {
 	for (int f=7; f>=0; f--) {
 	    const int index = 8*r + f;
 	    const uint64_t mask = (1ULL << index);
-	    if (mask & gs.board.wPawns) {            if (empties > 0) fen += std::to_string(empties); fen += "P"; empties = 0;
-	    } else if (mask & gs.board.wKnights) {   if (empties > 0) fen += std::to_string(empties); fen += "N"; empties = 0;
-	    } else if (mask & gs.board.wBishops) {   if (empties > 0) fen += std::to_string(empties); fen += "B"; empties = 0;
-	    } else if (mask & gs.board.wRooks) {     if (empties > 0) fen += std::to_string(empties); fen += "R"; empties = 0;
-	    } else if (mask & gs.board.wQueens) {    if (empties > 0) fen += std::to_string(empties); fen += "Q"; empties = 0;
-	    } else if (mask & gs.board.wKing) {      if (empties > 0) fen += std::to_string(empties); fen += "K"; empties = 0;
-	    } else if (mask & gs.board.bPawns) {     if (empties > 0) fen += std::to_string(empties); fen += "p"; empties = 0;
-	    } else if (mask & gs.board.bKnights) {   if (empties > 0) fen += std::to_string(empties); fen += "n"; empties = 0;
-	    } else if (mask & gs.board.bBishops) {   if (empties > 0) fen += std::to_string(empties); fen += "b"; empties = 0;
-	    } else if (mask & gs.board.bRooks) {     if (empties > 0) fen += std::to_string(empties); fen += "r"; empties = 0;
-	    } else if (mask & gs.board.bQueens) {    if (empties > 0) fen += std::to_string(empties); fen += "q"; empties = 0;
-	    } else if (mask & gs.board.bKing) {      if (empties > 0) fen += std::to_string(empties); fen += "k"; empties = 0;
+	    if (mask & gs.board.wPawns()) {            if (empties > 0) fen += std::to_string(empties); fen += "P"; empties = 0;
+	    } else if (mask & gs.board.wKnights()) {   if (empties > 0) fen += std::to_string(empties); fen += "N"; empties = 0;
+	    } else if (mask & gs.board.wBishops()) {   if (empties > 0) fen += std::to_string(empties); fen += "B"; empties = 0;
+	    } else if (mask & gs.board.wRooks()) {     if (empties > 0) fen += std::to_string(empties); fen += "R"; empties = 0;
+	    } else if (mask & gs.board.wQueens()) {    if (empties > 0) fen += std::to_string(empties); fen += "Q"; empties = 0;
+	    } else if (mask & gs.board.wKing()) {      if (empties > 0) fen += std::to_string(empties); fen += "K"; empties = 0;
+	    } else if (mask & gs.board.bPawns()) {     if (empties > 0) fen += std::to_string(empties); fen += "p"; empties = 0;
+	    } else if (mask & gs.board.bKnights()) {   if (empties > 0) fen += std::to_string(empties); fen += "n"; empties = 0;
+	    } else if (mask & gs.board.bBishops()) {   if (empties > 0) fen += std::to_string(empties); fen += "b"; empties = 0;
+	    } else if (mask & gs.board.bRooks()) {     if (empties > 0) fen += std::to_string(empties); fen += "r"; empties = 0;
+	    } else if (mask & gs.board.bQueens()) {    if (empties > 0) fen += std::to_string(empties); fen += "q"; empties = 0;
+	    } else if (mask & gs.board.bKing()) {      if (empties > 0) fen += std::to_string(empties); fen += "k"; empties = 0;
 	    } else {
 		empties++;
 	    }
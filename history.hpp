@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/******************************************************************************
+ * Repetition history
+ *
+ * Zobrist hashes of the positions before the current one, oldest first. The
+ * game keeps only the hashes since the last irreversible move (capture or
+ * pawn move), the search pushes one hash per ply on top of them and pops it
+ * again. Grows as needed, so long games cannot overflow it.
+ */
+class History {
+public:
+    void push(const uint64_t zhash) { hashes.push_back(zhash); }
+    void pop() { hashes.pop_back(); }
+    void clear() { hashes.clear(); }
+    bool empty() const { return hashes.empty(); }
+
+    // true if the position with hash 'zhash' occurred before, looking back
+    // at most 'halfmoveClock' plies (the last irreversible move) and only at
+    // positions with the same side to move
+    bool isRepetition(const uint64_t zhash, const int halfmoveClock) const {
+	const int size = (int)hashes.size();
+	const int oldest = (halfmoveClock < size ? size - halfmoveClock : 0);
+	for (int i=size-2; i>=oldest; i-=2) {
+	    if (hashes[i] == zhash) return true;
+	}
+	return false;
+    }
+
+private:
+    std::vector<uint64_t> hashes;
+};
@@ -0,0 +1,178 @@
+#include "magics.hpp"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "params.hpp"
+#include "movegenerator.hpp"
+#include "raylookup.hpp"
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+// shared attack tables, sized for the sum over all squares of
+// 2^(relevant occupancy bits)
+bitb rookTable[102400];
+bitb bishopTable[5248];
+
+// same for the PEXT tables, indexed by the compressed relevant occupancy
+bitb* rookPext[64];
+bitb* bishopPext[64];
+bitb rookPextTable[102400];
+bitb bishopPextTable[5248];
+
+// Magic factors, found once with a sparse random search (AND of three
+// mt19937_64 numbers). They are kept as constants, searching them on every
+// startup takes several hundred milliseconds.
+constexpr bitb rookFactors[64] = {
+    0x280132180004001ULL, 0x140001000200040ULL,
+    0x880200010000880ULL, 0x2080080005801000ULL,
+    0x200041020080200ULL, 0x200041041084200ULL,
+    0x400080081124410ULL, 0x2180042100004080ULL,
+    0x8000800099644000ULL, 0x802003040820100ULL,
+    0x105801001862000ULL, 0x101002008100100ULL,
+    0x1000800400080080ULL, 0x804800200040080ULL,
+    0x2001800200800900ULL, 0x160004088204c1ULL,
+    0x228000c001402000ULL, 0x8510004000200050ULL,
+    0x3001848020029000ULL, 0x280808010000801ULL,
+    0x109010010040800ULL, 0x8000808004000200ULL,
+    0x8000040081021028ULL, 0x40040a0009004884ULL,
+    0x80c0004280008035ULL, 0x10004040002000ULL,
+    0x1101200500410070ULL, 0x8410100080080080ULL,
+    0xc080080800400ULL, 0x4012008080040002ULL,
+    0x4000040101000200ULL, 0x61010200008044ULL,
+    0x80804010800020ULL, 0x3000201008400040ULL,
+    0x4112008012002444ULL, 0x848000880801000ULL,
+    0xa8008008800400ULL, 0x200200280a00500cULL,
+    0x80a221024004801ULL, 0xc400008042000104ULL,
+    0x8000400080028022ULL, 0x220008040018020ULL,
+    0x4000200011010040ULL, 0x10060040210a0010ULL,
+    0x40820020904a0004ULL, 0x30040002008080ULL,
+    0x200020801840010ULL, 0x84c04100820004ULL,
+    0x4802010080c2a600ULL, 0x400080201880ULL,
+    0x2040801000200080ULL, 0x180200842001200ULL,
+    0x13510008000500ULL, 0x182000c00808a80ULL,
+    0x1000524821302400ULL, 0x3800040108488200ULL,
+    0x104a004810210082ULL, 0x4210010420082ULL,
+    0xc424110008200241ULL, 0x90101000a0088501ULL,
+    0x182000420100802ULL, 0x4822001001080402ULL,
+    0x5d0080090012204ULL, 0x2008140089042846ULL
+};
+
+constexpr bitb bishopFactors[64] = {
+    0xc08081028882700ULL, 0x208088820424040ULL,
+    0x2188480100202561ULL, 0x4104610800140ULL,
+    0x9004504100002000ULL, 0xa010108c0010041ULL,
+    0x3800491028200000ULL, 0x802101202002ULL,
+    0x81020410b0810100ULL, 0x408082808404040ULL,
+    0x106220084008008ULL, 0x40182841001082ULL,
+    0x158404504000800eULL, 0x888810108432808ULL,
+    0x100020811180808ULL, 0x801420a02410400ULL,
+    0x1320559102103101ULL, 0x182002002240102ULL,
+    0xa910000200260020ULL, 0x8010628210000ULL,
+    0x8002000402114461ULL, 0x204410080800ULL,
+    0x400500205100900ULL, 0x2002014880840100ULL,
+    0x1e1100108102148ULL, 0x410090044115400ULL,
+    0x4004084010104040ULL, 0x202002008008220ULL,
+    0x1001105004020ULL, 0x1081022080400ULL,
+    0x2018842000820806ULL, 0x40008e0000210401ULL,
+    0x2314104102082200ULL, 0x2100500101109ULL,
+    0x1224040201411200ULL, 0x202004040040102ULL,
+    0x40002022020080ULL, 0x2020004081210080ULL,
+    0x442020404004401ULL, 0x408c08a00090104ULL,
+    0x898a21821004003ULL, 0xb004189210424820ULL,
+    0x8008131088031000ULL, 0x9010148010500ULL,
+    0x2100084104000040ULL, 0x110102108200a100ULL,
+    0x10120801144060ULL, 0x2020a24200200ULL,
+    0x20880808040000ULL, 0xa8b041201040103ULL,
+    0x140120205114002ULL, 0x6282000242021201ULL,
+    0x80080140d0c0122ULL, 0x181102011810200ULL,
+    0x804041032420400ULL, 0x20842c00414142ULL,
+    0x6498028010c2082ULL, 0x62202084042010ULL,
+    0x8100000211008800ULL, 0x6000000000840400ULL,
+    0x18000008210100ULL, 0x40011a0010100ULL,
+    0x820090210020204ULL, 0x402482804858200ULL
+};
+
+/******************************************************************************
+ * Fills the magic entries and the corresponding part of 'table' and
+ * 'pextTable' for all squares. The attacks are taken from the ray-scan
+ * implementation for every subset of the relevant occupancy.
+ *
+ * The subsets are enumerated via Carry-Rippler, which visits them in
+ * increasing order of their PEXT index. The PEXT tables can therefore be
+ * filled without executing PEXT itself.
+ */
+static void initSlider(Magic magics[64], bitb* table, const bitb masks[64],
+			const bitb factors[64], bitb* pext[64], bitb* pextTable,
+			bitb (*refAttacks)(const bitb, const int)) {
+    bitb* next = table;
+    bitb* nextPext = pextTable;
+    for (int sq=0; sq<64; sq++) {
+	Magic& m = magics[sq];
+	m.mask = masks[sq];
+	m.magic = factors[sq];
+	m.shift = 64 - POP(m.mask);
+	m.attacks = next;
+	pext[sq] = nextPext;
+	next += (1ULL << POP(m.mask));
+	nextPext += (1ULL << POP(m.mask));
+
+	bitb subset = 0ULL;
+	int pextIndex = 0;
+	do {
+	    const bitb atks = refAttacks(subset, sq);
+	    m.attacks[m.index(subset)] = atks;
+	    pext[sq][pextIndex++] = atks;
+	    subset = (subset - m.mask) & m.mask;
+	} while (subset);
+    }
+}
+
+/******************************************************************************
+ * Function that fills the magic entries and attack tables. Has to be called
+ * once at startup before any move generation.
+ */
+void initMagics() {
+    constexpr bitb rank1 = 0xffULL;
+    constexpr bitb rank8 = 0xff00000000000000ULL;
+    constexpr bitb aFile = 0x8080808080808080ULL;
+    constexpr bitb hFile = 0x101010101010101ULL;
+
+    // relevant occupancy, the last square of a ray never blocks anything
+    bitb rookMasks[64];
+    bitb bishopMasks[64];
+    for (int sq=0; sq<64; sq++) {
+	rookMasks[sq] = (nRays[sq] & ~rank8) | (sRays[sq] & ~rank1)
+		      | (eRays[sq] & ~hFile) | (wRays[sq] & ~aFile);
+	bishopMasks[sq] = (neRays[sq] | nwRays[sq] | seRays[sq] | swRays[sq])
+			& ~(rank1 | rank8 | aFile | hFile);
+    }
+
+    initSlider(rookMagics, rookTable, rookMasks, rookFactors,
+		rookPext, rookPextTable, rayRookAttacks);
+    initSlider(bishopMagics, bishopTable, bishopMasks, bishopFactors,
+		bishopPext, bishopPextTable, rayBishopAttacks);
+}
+
+/******************************************************************************
+ * Returns true if the CPU supports BMI2 and executes PEXT in hardware. AMD
+ * CPUs before Zen 3 (family 0x19) support BMI2 but microcode PEXT, which is
+ * slower than the magic multiplication.
+ */
+bool fastPext() {
+#if defined(__x86_64__)
+    if (not __builtin_cpu_supports("bmi2")) return false;
+    if (__builtin_cpu_is("amd")) {
+	unsigned int eax, ebx, ecx, edx;
+	if (not __get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	// family = base family + extended family
+	const unsigned int family = ((eax >> 8) & 0xf) + ((eax >> 20) & 0xff);
+	return family >= 0x19;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
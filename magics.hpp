@@ -0,0 +1,80 @@
+#pragma once
+
+#include "params.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/******************************************************************************
+ * This file contains the fancy magic bitboards and the PEXT tables used to
+ * look up the attacks of sliding pieces.
+ *****************************************************************************/
+
+
+/******************************************************************************
+ * Magic entry for a single square
+ *
+ * The relevant occupancy (the rays of the piece without the board edges) is
+ * multiplied by the magic factor, the upper bits of the product are then a
+ * perfect index into the attack table of this square.
+ */
+struct Magic {
+    bitb mask;     // relevant occupancy
+    bitb magic;    // magic factor
+    bitb* attacks; // attack table of this square
+    int shift;     // 64 - number of relevant occupancy bits
+
+    unsigned int index(const bitb occ) const {
+	return static_cast<unsigned int>(((occ & mask) * magic) >> shift);
+    }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+extern bitb* rookPext[64];
+extern bitb* bishopPext[64];
+
+/******************************************************************************
+ * Function that fills the magic entries and attack tables (magic and PEXT).
+ * Has to be called once at startup before any move generation.
+ */
+void initMagics();
+
+/******************************************************************************
+ * Returns true if the CPU supports BMI2 and executes PEXT in hardware. AMD
+ * CPUs before Zen 3 support BMI2 but microcode PEXT, which is slower than the
+ * magic multiplication.
+ */
+bool fastPext();
+
+/******************************************************************************
+ * Attack lookups for rooklike and bishoplike sliders.
+ */
+inline bitb magicRookAttacks(const bitb occ, const int index) {
+    const Magic& m = rookMagics[index];
+    return m.attacks[m.index(occ)];
+}
+
+inline bitb magicBishopAttacks(const bitb occ, const int index) {
+    const Magic& m = bishopMagics[index];
+    return m.attacks[m.index(occ)];
+}
+
+/******************************************************************************
+ * PEXT lookups, the index is the relevant occupancy compressed to the low bits.
+ * Compiled for BMI2 regardless of the build flags, only call these if
+ * 'fastPext()' returned true.
+ */
+#if defined(__x86_64__)
+__attribute__((target("bmi2")))
+inline bitb pextRookAttacks(const bitb occ, const int index) {
+    return rookPext[index][_pext_u64(occ, rookMagics[index].mask)];
+}
+
+__attribute__((target("bmi2")))
+inline bitb pextBishopAttacks(const bitb occ, const int index) {
+    return bishopPext[index][_pext_u64(occ, bishopMagics[index].mask)];
+}
+#endif
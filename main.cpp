@@ -1,6 +1,5 @@
 #include <iostream>
 #include <fstream>
-#include <vector>
 #include <sstream>
 #include <time.h>
 #include <iomanip>
@@ -15,6 +14,7 @@
 #include "eval.hpp"
 #include "pvssearch.hpp"
 #include "zobrist.hpp"
+#include "magics.hpp"
 
 using namespace std::chrono;
 
@@ -52,6 +52,8 @@ int main(int argc, char* argv[]) {
 	<< (ttsize*sizeof(TTentry)/1000/1000) << " MB\n";
 
     const zobristKeys zobrist = initZobrist();
+    initMagics();
+    sliderBackend = detectSliderBackend();
 
     // delete old statfile in case of restart
     if constexpr (azalea::statistics) deleteStatfile();
@@ -62,6 +64,9 @@ int main(int argc, char* argv[]) {
 	= fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
 		zobrist);
 
+    // hashes of the game since the last irreversible move
+    History history;
+
     bool inCheck = false;
     UnmakeInfo umi;
 
@@ -95,6 +100,47 @@ int main(int argc, char* argv[]) {
 	    std::cout << "dec: " << gs.zhash << "\n";
 	    std::cout << "hex: " << std::hex << gs.zhash << std::dec << "\n";
 
+	// slider attack backend
+	} else if (command.substr(0, 8) == "sliders ") {
+	    if (command.substr(8) == "pext") {
+		if (fastPext()) sliderBackend = SliderBackend::pext;
+		else std::cout << "PEXT not supported (or slow) on this CPU\n";
+	    } else if (command.substr(8) == "magic") {
+		sliderBackend = SliderBackend::magic;
+	    } else if (command.substr(8) == "rays") {
+		sliderBackend = SliderBackend::rays;
+	    } else {
+		std::cout << "Unknown slider backend: " << command.substr(8)
+								<< "\n";
+	    }
+
+	// set-wise attack backend (king danger)
+	} else if (command.substr(0, 6) == "fills ") {
+	    if (command.substr(6) == "avx2") {
+		if (detectFillBackend() == FillBackend::avx2)
+		    fillBackend = FillBackend::avx2;
+		else std::cout << "AVX2 not supported on this CPU\n";
+	    } else if (command.substr(6) == "kogge-stone") {
+		fillBackend = FillBackend::scalar;
+	    } else if (command.substr(6) == "lookup") {
+		fillBackend = FillBackend::lookup;
+	    } else {
+		std::cout << "Unknown fill backend: " << command.substr(6)
+								<< "\n";
+	    }
+
+	// perft benchmark of the slider backends
+	} else if (command == "bench") {
+	    bench(zobrist);
+
+	// null move consistency test from the current position
+	} else if (command.substr(0, 9) == "nulltest ") {
+	    nullMoveTest(gs, std::stoi(command.substr(9)), zobrist);
+
+	// givesCheck consistency test over fixed positions
+	} else if (command == "checktest") {
+	    givesCheckTest(zobrist);
+
 	// fen
 	} else if (command == "fen") {
 	    std::cout << "FEN: " <<  toFen(gs) << "\n";
@@ -105,25 +151,30 @@ int main(int argc, char* argv[]) {
 
 	// move
 	} else if (command.substr(0, 5) == "move ") {
-	    std::vector<Move> ml;
+	    MoveList ml;
 	    generateLegalMoves(gs, ml, inCheck);
 	    std::string mstr = command.substr(5);
 	    bool legal = false;
 	    for (const auto& m: ml) {
 		if (mstr == toString(m)) {
+		    history.push(gs.zhash);
 		    umi = gs.makeMove(m, zobrist);
+		    // nothing before it can repeat
+		    if (gs.halfmoveClock == 0) history.clear();
 		    legal = true;
 		}
 	    }
 	    if (not legal) std::cout << "illegal move!\n";
 
-	// unmake move
+	// unmake move (after an irreversible move the older hashes are gone,
+	// so repetitions with them are not found anymore)
 	} else if (command == "unmake") {
-	    gs.unmakeMove(umi, zobrist);
+	    gs.unmakeMove(umi);
+	    if (not history.empty()) history.pop();
 
 	// legal moves
 	} else if (command == "legalmoves") {
-	    std::vector<Move> ml;
+	    MoveList ml;
 	    generateLegalMoves(gs, ml, inCheck);
 	    for (const auto& m: ml) {
 		std::cout << m << "  ";
@@ -132,6 +183,7 @@ int main(int argc, char* argv[]) {
 
 	// uci standard stuff
 	} else if (command == "ucinewgame") {
+	    history.clear();
 	    gs =
 	    fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
 		    zobrist);
@@ -140,6 +192,7 @@ int main(int argc, char* argv[]) {
 
 	// position section
 	} else if (command.substr(0, 8) == "position") {
+	    history.clear();
 	    if (command.substr(9, 8) == "startpos") {
 		gs = fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR"
 			    " w KQkq - 0 1", zobrist);
@@ -156,11 +209,14 @@ int main(int argc, char* argv[]) {
 			// now actually make these moves
 			std::string mstring;
 			while (getline(mm, mstring, ' ')) {
-		    	std::vector<Move> ml;
+		    	MoveList ml;
 		    	generateLegalMoves(gs, ml, inCheck);
 		    	for (const auto& m: ml) {
 				    if (mstring == toString(m)) {
+				    history.push(gs.zhash);
 				    gs.makeMove(m, zobrist);
+				    // nothing before it can repeat
+				    if (gs.halfmoveClock == 0) history.clear();
 				}
 			    }
 			}
@@ -178,19 +234,19 @@ int main(int argc, char* argv[]) {
 		const int depth
 			    = std::stoi(command.substr(9, command.length()));
 		movetime = -1;
-		search(gs, depth, zobrist);
+		search(gs, history, depth, zobrist);
 	    } else if (command.substr(3, 9) == "infinite") {
 		movetime = -1;
-		search(gs, azalea::maxDepth, zobrist);
+		search(gs, history, azalea::maxDepth, zobrist);
 	    } else if (command.substr(3, 8) == "movetime") {
 		movetime = std::stoi(command.substr(12, command.length()));
 		if constexpr (azalea::statistics)
 		    outputStats("got 'go movetime " + std::to_string(movetime)
 								    + "'\n");
-		search(gs, azalea::maxDepth, zobrist);
+		search(gs, history, azalea::maxDepth, zobrist);
 	    } else {
 			// just make a random move
-			std::vector<Move> ml;
+			MoveList ml;
 			generateLegalMoves(gs, ml, inCheck);
 			srand(time(NULL));
 			const int random = rand() % ml.size();
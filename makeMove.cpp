@@ -2,16 +2,21 @@
 #include "board.hpp"
 #include "move.hpp"
 #include "util.hpp"
+#include "eval.hpp"
+
+// piece a pawn promotes to
+static inline pieceType promotionType(const char promoPiece) {
+    switch (promoPiece) {
+	case 'n': return pieceType::knight;
+	case 'b': return pieceType::bishop;
+	case 'r': return pieceType::rook;
+	default: return pieceType::queen;
+    }
+}
 
 UnmakeInfo GameState::makeMove(const Move& m, const zobristKeys& zobrist) {
-    const int from = m.from;
-    const int to = m.to;
-    const bitb fromMask = (1ULL << from);
-    const bitb toMask = (1ULL << to);
-
-    // add hash to repetition history array
-    this->repHist[this->repPlyCounter] = this->zhash;
-    this->repPlyCounter++;
+    const int from = m.from();
+    const int to = m.to();
 
     Board& b = this->board;
 
@@ -20,66 +25,46 @@ UnmakeInfo GameState::makeMove(const Move& m, const zobristKeys& zobrist) {
     umi.from = from;
     umi.to = to;
     umi.capturedPiece = pieceType::none;
-    umi.promotion = m.promo;
-    umi.castle = m.castle;
-    umi.ep = m.ep;
+    umi.promotion = m.promo();
+    umi.castle = m.castle();
+    umi.ep = m.ep();
     umi.epTarget = this->epTarget;
     umi.whiteShort = this->whiteShort;
     umi.whiteLong = this->whiteLong;
     umi.blackShort = this->blackShort;
     umi.blackLong = this->blackLong;
-
-    if (m.capture) {
-	if (toMask & (b.wPawns | b.bPawns)) {
-	    umi.capturedPiece = pieceType::pawn;
-	    if (not m.ep) {
-		if (this->whiteToMove) {
-		    this->zhash ^= zobrist.pieceSquare[1][0][to];
-		} else {
-		    this->zhash ^= zobrist.pieceSquare[0][0][to];
-		}
-	    }
-	} else if (toMask & (b.wKnights | b.bKnights)) {
-	    umi.capturedPiece = pieceType::knight;
-	    if (this->whiteToMove) {
-		this->zhash ^= zobrist.pieceSquare[1][1][to];
-	    } else {
-		this->zhash ^= zobrist.pieceSquare[0][1][to];
-	    }
-	} else if (toMask & (b.wBishops | b.bBishops)) {
-	    umi.capturedPiece = pieceType::bishop;
-	    if (this->whiteToMove) {
-		this->zhash ^= zobrist.pieceSquare[1][2][to];
-	    } else {
-		this->zhash ^= zobrist.pieceSquare[0][2][to];
-	    }
-	} else if (toMask & (b.wRooks | b.bRooks)) {
-	    umi.capturedPiece = pieceType::rook;
-	    if (this->whiteToMove) {
-		this->zhash ^= zobrist.pieceSquare[1][3][to];
-	    } else {
-		this->zhash ^= zobrist.pieceSquare[0][3][to];
-	    }
-	} else if (toMask & (b.wQueens | b.bQueens)) {
-	    if (this->whiteToMove) {
-		this->zhash ^= zobrist.pieceSquare[1][4][to];
-	    } else {
-		this->zhash ^= zobrist.pieceSquare[0][4][to];
-	    }
-	    umi.capturedPiece = pieceType::queen;
-	}
-    }
-
-    // if en passant capture, remove pawn
-    if (m.ep) {
+    umi.halfmoveClock = this->halfmoveClock;
+    umi.zhash = this->zhash;
+    umi.pawnKey = this->pawnKey;
+    umi.materialKey = this->materialKey;
+    umi.earlySum = this->earlySum;
+    umi.lateSum = this->lateSum;
+    umi.phase = this->phase;
+
+    const int us = (this->whiteToMove ? 0 : 1);
+    const int them = 1 - us;
+
+    // remove the captured piece (looked up in the mailbox), an en passant
+    // captured pawn is not on the to-square
+    if (m.ep()) {
 	const int index = (to%8) + 8*(from/8); // looks stupid, makes sense
-	b.wPawns &= ~(1ULL << index);
-	b.bPawns &= ~(1ULL << index);
-	if (this->whiteToMove) {
-	    this->zhash ^= zobrist.pieceSquare[1][0][index];
-	} else {
-	    this->zhash ^= zobrist.pieceSquare[0][0][index];
-	}
+	umi.capturedPiece = pieceType::pawn;
+	b.removePiece(them, pieceType::pawn, index);
+	evalRemovePiece(*this, them, pieceType::pawn, index);
+	this->zhash ^= zobrist.pieceSquare[them][0][index];
+	this->pawnKey ^= zobrist.pieceSquare[them][0][index];
+	this->materialKey
+	    ^= zobrist.material[them][0][POP(b.get(them, pieceType::pawn))];
+    } else if (m.capture()) {
+	const pieceType captured = b.squares[to];
+	umi.capturedPiece = captured;
+	b.removePiece(them, captured, to);
+	evalRemovePiece(*this, them, captured, to);
+	this->zhash ^= zobrist.pieceSquare[them][pieceIndex(captured)][to];
+	if (captured == pieceType::pawn)
+	    this->pawnKey ^= zobrist.pieceSquare[them][0][to];
+	this->materialKey ^= zobrist.material[them][pieceIndex(captured)]
+					     [POP(b.get(them, captured))];
     }
 
     // reset ep target
@@ -110,168 +95,59 @@ UnmakeInfo GameState::makeMove(const Move& m, const zobristKeys& zobrist) {
     if (this->blackShort != umi.blackShort) this->zhash ^= zobrist.castling[2];
     if (this->blackLong  != umi.blackLong)  this->zhash ^= zobrist.castling[3];
 
-    // first zero the to-square everywhere (king not needed, cant be captured)
-    // for an ep capture another square needs to be cleared as well (later)
-    b.wPawns &= ~toMask;
-    b.wKnights &= ~toMask;
-    b.wBishops &= ~toMask;
-    b.wRooks &= ~toMask;
-    b.wQueens &= ~toMask;
-    b.bPawns &= ~toMask;
-    b.bKnights &= ~toMask;
-    b.bBishops &= ~toMask;
-    b.bRooks &= ~toMask;
-    b.bQueens &= ~toMask;
-    
-    if (this->whiteToMove) {
-	// get moving piece and move it
-	if (b.wPawns & fromMask) {
-	    b.wPawns ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[0][0][from];
-	    this->zhash ^= zobrist.pieceSquare[0][0][to];
-	} else if (b.wKnights & fromMask) {
-	    b.wKnights ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[0][1][from];
-	    this->zhash ^= zobrist.pieceSquare[0][1][to];
-	} else if (b.wBishops & fromMask) {
-	    b.wBishops ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[0][2][from];
-	    this->zhash ^= zobrist.pieceSquare[0][2][to];
-	} else if (b.wRooks & fromMask) {
-	    b.wRooks ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[0][3][from];
-	    this->zhash ^= zobrist.pieceSquare[0][3][to];
-	} else if (b.wQueens & fromMask) {
-	    b.wQueens ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[0][4][from];
-	    this->zhash ^= zobrist.pieceSquare[0][4][to];
-	} else if (b.wKing & fromMask) {
-	    b.wKing = toMask;
-	    this->zhash ^= zobrist.pieceSquare[0][5][from];
-	    this->zhash ^= zobrist.pieceSquare[0][5][to];
-	}
-    } else { // black moves
-	// get moving piece and move it
-	if (b.bPawns & fromMask) {
-	    b.bPawns ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[1][0][from];
-	    this->zhash ^= zobrist.pieceSquare[1][0][to];
-	} else if (b.bKnights & fromMask) {
-	    b.bKnights ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[1][1][from];
-	    this->zhash ^= zobrist.pieceSquare[1][1][to];
-	} else if (b.bBishops & fromMask) {
-	    b.bBishops ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[1][2][from];
-	    this->zhash ^= zobrist.pieceSquare[1][2][to];
-	} else if (b.bRooks & fromMask) {
-	    b.bRooks ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[1][3][from];
-	    this->zhash ^= zobrist.pieceSquare[1][3][to];
-	} else if (b.bQueens & fromMask) {
-	    b.bQueens ^= (fromMask | toMask);
-	    this->zhash ^= zobrist.pieceSquare[1][4][from];
-	    this->zhash ^= zobrist.pieceSquare[1][4][to];
-	} else if (b.bKing & fromMask) {
-	    b.bKing = toMask;
-	    this->zhash ^= zobrist.pieceSquare[1][5][from];
-	    this->zhash ^= zobrist.pieceSquare[1][5][to];
-	}
+    // get moving piece and move it
+    const pieceType moving = b.squares[from];
+    b.movePiece(us, moving, from, to);
+    evalMovePiece(*this, us, moving, from, to);
+
+    // captures and pawn moves are irreversible
+    if (m.capture() or moving == pieceType::pawn) this->halfmoveClock = 0;
+    else this->halfmoveClock++;
+    this->zhash ^= zobrist.pieceSquare[us][pieceIndex(moving)][from];
+    this->zhash ^= zobrist.pieceSquare[us][pieceIndex(moving)][to];
+    if (moving == pieceType::pawn) {
+	this->pawnKey ^= zobrist.pieceSquare[us][0][from];
+	this->pawnKey ^= zobrist.pieceSquare[us][0][to];
     }
 
     // double pawn push -> set ep square
-    if (m.doublePawnPush) {
+    if (m.doublePawnPush()) {
 	this->epTarget = (from + to)/2;
 	this->zhash ^= zobrist.epFile[fileOf(this->epTarget)];
     }
 
     // promotions
-    if (m.promo) {
-	// we already move the pawn, now the pawn needs to be replaced with the
-	// respective piece it's promoting to (can obviously be done more
-	// efficient)
-	if (this->whiteToMove) {
-	    b.wPawns ^= toMask;
-	    switch (m.promoPiece) {
-		case 'q':
-		    b.wQueens ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[0][0][to];
-		    this->zhash ^= zobrist.pieceSquare[0][4][to];
-		    break;
-		case 'n':
-		    b.wKnights ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[0][0][to];
-		    this->zhash ^= zobrist.pieceSquare[0][1][to];
-		    break;
-		case 'b':
-		    b.wBishops ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[0][0][to];
-		    this->zhash ^= zobrist.pieceSquare[0][2][to];
-		    break;
-		case 'r':
-		    b.wRooks ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[0][0][to];
-		    this->zhash ^= zobrist.pieceSquare[0][3][to];
-		    break;
-	    }
-	} else { // black
-	    b.bPawns ^= toMask;
-	    switch (m.promoPiece) {
-		case 'q':
-		    b.bQueens ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[1][0][to];
-		    this->zhash ^= zobrist.pieceSquare[1][4][to];
-		    break;
-		case 'n':
-		    b.bKnights ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[1][0][to];
-		    this->zhash ^= zobrist.pieceSquare[1][1][to];
-		    break;
-		case 'b':
-		    b.bBishops ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[1][0][to];
-		    this->zhash ^= zobrist.pieceSquare[1][2][to];
-		    break;
-		case 'r':
-		    b.bRooks ^= toMask;
-		    this->zhash ^= zobrist.pieceSquare[1][0][to];
-		    this->zhash ^= zobrist.pieceSquare[1][3][to];
-		    break;
-	    }
-	}
+    if (m.promo()) {
+	// we already moved the pawn, now the pawn needs to be replaced with the
+	// respective piece it's promoting to
+	const pieceType promoted = promotionType(m.promoPiece());
+	b.removePiece(us, pieceType::pawn, to);
+	b.addPiece(us, promoted, to);
+	evalRemovePiece(*this, us, pieceType::pawn, to);
+	evalAddPiece(*this, us, promoted, to);
+	this->zhash ^= zobrist.pieceSquare[us][0][to];
+	this->zhash ^= zobrist.pieceSquare[us][pieceIndex(promoted)][to];
+	this->pawnKey ^= zobrist.pieceSquare[us][0][to];
+	this->materialKey
+	    ^= zobrist.material[us][0][POP(b.get(us, pieceType::pawn))];
+	this->materialKey ^= zobrist.material[us][pieceIndex(promoted)]
+					     [POP(b.get(us, promoted)) - 1];
     }
 
     // castling
-    if (m.castle) {
+    if (m.castle()) {
 	// we already moved the king, only the rook is left
-	if (to ==  1) { // white kingside
-	    b.wRooks ^= 0x5ULL;
-	    this->zhash ^= zobrist.pieceSquare[0][3][2];
-	    this->zhash ^= zobrist.pieceSquare[0][3][0];
-	}
-	if (to ==  5) { // white queenside
-	    b.wRooks ^= 0x90ULL;
-	    this->zhash ^= zobrist.pieceSquare[0][3][4];
-	    this->zhash ^= zobrist.pieceSquare[0][3][7];
-	}
-	if (to == 57) { // black kingside
-	    b.bRooks ^= 0x500000000000000ULL;
-	    this->zhash ^= zobrist.pieceSquare[1][3][58];
-	    this->zhash ^= zobrist.pieceSquare[1][3][56];
-	}
-	if (to == 61) { // black queenside
-	    b.bRooks ^= 0x9000000000000000ULL;
-	    this->zhash ^= zobrist.pieceSquare[1][3][60];
-	    this->zhash ^= zobrist.pieceSquare[1][3][63];
-	}
+	int rookFrom = 0, rookTo = 0;
+	if (to ==  1) { rookFrom =  0; rookTo =  2; } // white kingside
+	if (to ==  5) { rookFrom =  7; rookTo =  4; } // white queenside
+	if (to == 57) { rookFrom = 56; rookTo = 58; } // black kingside
+	if (to == 61) { rookFrom = 63; rookTo = 60; } // black queenside
+	b.movePiece(us, pieceType::rook, rookFrom, rookTo);
+	evalMovePiece(*this, us, pieceType::rook, rookFrom, rookTo);
+	this->zhash ^= zobrist.pieceSquare[us][3][rookFrom];
+	this->zhash ^= zobrist.pieceSquare[us][3][rookTo];
     }
 
-    b.white = b.wPawns | b.wKnights | b.wBishops
-	    | b.wRooks | b.wQueens | b.wKing;
-    b.black = b.bPawns | b.bKnights | b.bBishops
-	    | b.bRooks | b.bQueens | b.bKing;
-    b.occ = b.white | b.black;
-
     // switch color of course
     this->whiteToMove = !this->whiteToMove;
     this->zhash ^= zobrist.sideToMove;
@@ -279,3 +155,24 @@ UnmakeInfo GameState::makeMove(const Move& m, const zobristKeys& zobrist) {
     return umi;
 }
 
+NullUnmakeInfo GameState::makeNullMove(const zobristKeys& zobrist) {
+    NullUnmakeInfo numi;
+    numi.epTarget = this->epTarget;
+    numi.halfmoveClock = this->halfmoveClock;
+    numi.zhash = this->zhash;
+
+    // reset ep target
+    if (this->epTarget != -1) {
+	this->zhash ^= zobrist.epFile[fileOf(this->epTarget)];
+    }
+    this->epTarget = -1;
+
+    this->halfmoveClock++;
+
+    // switch color
+    this->whiteToMove = !this->whiteToMove;
+    this->zhash ^= zobrist.sideToMove;
+
+    return numi;
+}
+
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "params.hpp"
+
 /******************************************************************************
  * File containing the 'move' class
  *****************************************************************************/
@@ -7,39 +9,105 @@
 
 /******************************************************************************
  * Move class
+ *
+ * A move is packed into 16 bits:
+ * 	bits  0- 5: from square
+ * 	bits  6-11: to square
+ * 	bits 12-15: flags
+ * The flag nibble is 0 for a quiet move, 1 for a double pawn push, 2 for
+ * castling, 4 for a capture and 5 for an en passant capture. Promotions set
+ * bit 3 (and bit 2 if they capture), the low two bits are then the promotion
+ * piece (knight, bishop, rook, queen).
+ *
+ * The default constructed move (all bits zero, from == to) means 'no move'.
  */
 class Move {
 public:
-    int from;
-    int to;
+    Move() : data(0) {}
 
-    bool capture;
-    bool doublePawnPush;
-    bool ep;
-    bool castle;
-    bool promo;
-    char promoPiece;
+    Move(int f, int t, bool c, bool d, bool e, bool cas, bool p, char pp)
+	: data(static_cast<uint16_t>(f | (t << 6)
+		| (encodeFlags(c, d, e, cas, p, pp) << 12))) {}
 
-    Move() : from(0), to(0), capture(false), doublePawnPush(false), ep(false),
-		castle(false), promo(false), promoPiece(' ') {}
+    int from() const { return data & 0x3f; }
+    int to() const { return (data >> 6) & 0x3f; }
 
-    Move(int f, int t, bool c, bool d, bool e, bool cas, bool p, char pp)
-	: from(f), to(t), capture(c), doublePawnPush(d), ep(e),
-		castle(cas), promo(p), promoPiece(pp) {}
-
-    bool operator==(const Move& m) const {
-	return from==m.from and to==m.to and capture==m.capture
-	    and doublePawnPush==m.doublePawnPush and ep==m.ep
-	    and castle==m.castle and promo==m.promo
-	    and promoPiece==m.promoPiece;
+    bool capture() const { return data & captureFlag; }
+    bool doublePawnPush() const { return flags() == doublePushFlags; }
+    bool ep() const { return flags() == epFlags; }
+    bool castle() const { return flags() == castleFlags; }
+    bool promo() const { return data & promoFlag; }
+    char promoPiece() const {
+	return (promo() ? "nbrq"[(data >> 12) & 0x3] : ' ');
     }
+
+    bool operator==(const Move& m) const { return data == m.data; }
+    bool operator!=(const Move& m) const { return data != m.data; }
+
+private:
+    static constexpr uint16_t captureFlag = (4 << 12);
+    static constexpr uint16_t promoFlag = (8 << 12);
+    static constexpr int doublePushFlags = 1;
+    static constexpr int castleFlags = 2;
+    static constexpr int epFlags = 5;
+
+    int flags() const { return data >> 12; }
+
+    static int encodeFlags(bool c, bool d, bool e, bool cas, bool p, char pp) {
+	if (p) {
+	    const int piece = (pp == 'q' ? 3 : pp == 'r' ? 2 : pp == 'b' ? 1 : 0);
+	    return 8 | (c ? 4 : 0) | piece;
+	}
+	if (e) return epFlags;
+	if (c) return 4;
+	if (cas) return castleFlags;
+	if (d) return doublePushFlags;
+	return 0;
+    }
+
+    uint16_t data;
+};
+
+/******************************************************************************
+ * Fixed-capacity move list
+ *
+ * Lives on the stack, so generating moves at a node needs no heap allocation.
+ * The ordering score of each move is stored next to it.
+ */
+class MoveList {
+public:
+    // wrapped in a union so the moves are not default constructed every time
+    // a list is created, only 'n' of them are ever valid
+    union { Move moves[azalea::maxMoves]; };
+    int scores[azalea::maxMoves];
+    int n;
+
+    MoveList() : n(0) {}
+
+    void push_back(const Move& m) { moves[n++] = m; }
+    void clear() { n = 0; }
+    int size() const { return n; }
+
+    Move& operator[](const int i) { return moves[i]; }
+    const Move& operator[](const int i) const { return moves[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + n; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + n; }
 };
 
 // auxillary enum
-enum class pieceType { none, pawn, knight, bishop, rook, queen };
+enum class pieceType : uint8_t { none, pawn, knight, bishop, rook, queen, king };
+
+// index of a piece type in the zobrist keys (pawn 0 to king 5)
+constexpr int pieceIndex(const pieceType p) {
+    return static_cast<int>(p) - 1;
+}
 
 /******************************************************************************
- * Contains information to unmake a move.
+ * Contains information to unmake a move: the move itself and the state before
+ * it, which is restored as it is (one per ply, kept by the caller).
  */
 class UnmakeInfo {
 public:
@@ -54,5 +122,22 @@ public:
     bool whiteLong;
     bool blackShort;
     bool blackLong;
+    int halfmoveClock;
+    uint64_t zhash;
+    uint64_t pawnKey;
+    uint64_t materialKey;
+    int earlySum;
+    int lateSum;
+    int phase;
+};
+
+/******************************************************************************
+ * Contains information to unmake a null move.
+ */
+class NullUnmakeInfo {
+public:
+    int epTarget;
+    int halfmoveClock;
+    uint64_t zhash;
 };
 
@@ -1,6 +1,5 @@
 #include "movegenerator.hpp"
 
-#include <vector>
 #include <iostream> // to be deleted
 
 #include "params.hpp"
@@ -8,142 +7,466 @@
 #include "move.hpp"
 #include "raylookup.hpp"
 #include "movegenlookup.hpp"
+#include "magics.hpp"
+
+SliderBackend sliderBackend = SliderBackend::magic;
+FillBackend fillBackend = FillBackend::lookup;
+
+// adds a move from 'from' to every square in 'targets'
+static inline void addMoves(MoveList& movelist, const int from, bitb targets,
+							const bool capture) {
+    while (targets) {
+	const int to = BSF(targets);
+	targets &= targets - 1;
+	movelist.push_back(Move(from, to, capture, false, false,
+						false, false, ' '));
+    }
+}
+
+// adds all promotions from 'from' to 'to' ('tactical' keeps only the queen)
+template <GenType type>
+static inline void addPromotions(MoveList& movelist, const int from,
+					const int to, const bool capture) {
+    movelist.push_back(Move(from, to, capture, false, false, false, true, 'q'));
+    if (type == GenType::tactical and not capture) return;
+    movelist.push_back(Move(from, to, capture, false, false, false, true, 'n'));
+    movelist.push_back(Move(from, to, capture, false, false, false, true, 'r'));
+    movelist.push_back(Move(from, to, capture, false, false, false, true, 'b'));
+}
+
+// adds a pawn move to every square in 'targets', each pawn came from 'to-d'
+template <int d>
+static inline void addPawnMoves(MoveList& movelist, bitb targets,
+						const bool capture) {
+    while (targets) {
+	const int to = BSF(targets);
+	targets &= targets - 1;
+	movelist.push_back(Move(to-d, to, capture, false, false,
+						false, false, ' '));
+    }
+}
+
+// same for promotions
+template <GenType type, int d>
+static inline void addPawnPromotions(MoveList& movelist, bitb targets,
+						    const bool capture) {
+    while (targets) {
+	const int to = BSF(targets);
+	targets &= targets - 1;
+	addPromotions<type>(movelist, to-d, to, capture);
+    }
+}
+
+// adds a double pawn push to every square in 'targets'
+template <int d>
+static inline void addDoublePushes(MoveList& movelist, bitb targets) {
+    while (targets) {
+	const int to = BSF(targets);
+	targets &= targets - 1;
+	movelist.push_back(Move(to-2*d, to, false, true, false,
+					    false, false, ' '));
+    }
+}
 
 /******************************************************************************
- * Function that generates all legal moves in a given position, returns them
- * on 'movelist'.
+ * Stand-in for a move list that only counts the moves (bulk counted perft
+ * leaves). The generator is templated on the list type, the helpers above
+ * are overloaded to add up the sizes of the target sets instead of creating
+ * any moves. Only en passant and castling moves are still counted one by one.
+ */
+struct MoveCounter {
+    void clear() { n = 0; }
+    void push_back(const Move&) { n++; }
+    int n = 0;
+};
+
+static inline void addMoves(MoveCounter& counter, const int, bitb targets,
+								const bool) {
+    counter.n += POP(targets);
+}
+
+template <int d>
+static inline void addPawnMoves(MoveCounter& counter, bitb targets,
+								const bool) {
+    counter.n += POP(targets);
+}
+
+template <GenType type, int d>
+static inline void addPawnPromotions(MoveCounter& counter, bitb targets,
+						    const bool capture) {
+    const bool queenOnly = (type == GenType::tactical and not capture);
+    counter.n += POP(targets) * (queenOnly ? 1 : 4);
+}
+
+template <int d>
+static inline void addDoublePushes(MoveCounter& counter, bitb targets) {
+    counter.n += POP(targets);
+}
+
+// shifts a bitboard by 'd' squares, upwards (towards the 8th rank) if 'd' is
+// positive and downwards otherwise
+template <int d>
+static inline bitb shift(const bitb bb) {
+    if constexpr (d > 0) return bb << d;
+    else return bb >> -d;
+}
+
+/******************************************************************************
+ * Side to move templated versions of the helpers below, all color selections
+ * are resolved at compile time.
+ */
+template <bool wtm>
+static inline bitb pawnAttacks(const bitb pawns) {
+    constexpr bitb aFile = 0x8080808080808080ULL;
+    constexpr bitb hFile = 0x101010101010101ULL;
+    return shift<(wtm ? 7 : -9)>(pawns & ~hFile)
+	 | shift<(wtm ? 9 : -7)>(pawns & ~aFile);
+}
+
+template <bool wtm> static bitb generateKingDanger(const GameState& gs);
+
+// all enemy pieces (seen from the side 'wtm') that attack 'sq' on a board
+// with the occupancy 'occ'
+template <bool wtm>
+static inline bitb enemyAttackers(const Board& b, const int sq,
+						    const bitb occ) {
+    const bitb enemyRooklikeSlider = (wtm ? (b.bRooks() | b.bQueens())
+					  : (b.wRooks() | b.wQueens()));
+    const bitb enemyBishoplikeSlider = (wtm ? (b.bBishops() | b.bQueens())
+					    : (b.wBishops() | b.wQueens()));
+    return ((wtm ? b.bPawns() : b.wPawns()) & pawnAttacks<wtm>(1ULL << sq))
+	 | ((wtm ? b.bKnights() : b.wKnights()) & knightAttacks[sq])
+	 | ((wtm ? b.bKing() : b.wKing()) & kingAttacks[sq])
+	 | (enemyBishoplikeSlider & bishopAttacks(occ, sq))
+	 | (enemyRooklikeSlider & rookAttacks(occ, sq));
+}
+
+// enemy pieces giving check to the king of the side 'wtm'
+template <bool wtm>
+static inline bitb computeCheckers(const GameState& gs) {
+    const Board& b = gs.board;
+    return enemyAttackers<wtm>(b, BSF(wtm ? b.wKing() : b.bKing()), b.occ);
+}
+
+/******************************************************************************
+ * Computes the pinned pieces of the side 'wtm' on 'ci'.
+ *
+ * A potential pinner is any enemy slider on a line of the king (empty
+ * board). If there is exactly one piece between them and it is our own, it
+ * is pinned.
+ */
+template <bool wtm>
+static void computePins(const GameState& gs, CheckInfo& ci) {
+    const Board& b = gs.board;
+    const bitb own = (wtm ? b.white() : b.black());
+    const int ownKingIndex = BSF(wtm ? b.wKing() : b.bKing());
+
+    const bitb enemyRooklikeSlider = (wtm ? (b.bRooks() | b.bQueens())
+					  : (b.wRooks() | b.wQueens()));
+    const bitb enemyBishoplikeSlider = (wtm ? (b.bBishops() | b.bQueens())
+					    : (b.wBishops() | b.wQueens()));
+
+    ci.latPinned = 0x0ULL;
+    bitb potentialPinner
+	= enemyRooklikeSlider & rookAttacks(0x0ULL, ownKingIndex);
+    while (potentialPinner) {
+	const int pinnerIndex = BSF(potentialPinner);
+	potentialPinner &= potentialPinner - 1;
+	const bitb blockers = between[ownKingIndex][pinnerIndex] & b.occ;
+	if (not (blockers & (blockers - 1))) ci.latPinned |= blockers & own;
+    }
+
+    ci.diaPinned = 0x0ULL;
+    potentialPinner
+	= enemyBishoplikeSlider & bishopAttacks(0x0ULL, ownKingIndex);
+    while (potentialPinner) {
+	const int pinnerIndex = BSF(potentialPinner);
+	potentialPinner &= potentialPinner - 1;
+	const bitb blockers = between[ownKingIndex][pinnerIndex] & b.occ;
+	if (not (blockers & (blockers - 1))) ci.diaPinned |= blockers & own;
+    }
+}
+
+/******************************************************************************
+ * Computes the full check and pin information for the side 'wtm'.
+ */
+template <bool wtm>
+static CheckInfo computeCheckInfo(const GameState& gs) {
+    const Board& b = gs.board;
+    const bitb ownKing = (wtm ? b.wKing() : b.bKing());
+
+    CheckInfo ci;
+    ci.kingDanger = generateKingDanger<wtm>(gs);
+    ci.checkers = 0x0ULL;
+    if (ownKing & ci.kingDanger)
+	ci.checkers = enemyAttackers<wtm>(b, BSF(ownKing), b.occ);
+    computePins<wtm>(gs, ci);
+
+    return ci;
+}
+
+/******************************************************************************
+ * Same with the checkers already known, the king danger is only computed if
+ * in check (the evasion generator needs it).
+ */
+template <bool wtm>
+static CheckInfo computePinInfo(const GameState& gs, const bitb checkers) {
+    CheckInfo ci;
+    ci.checkers = checkers;
+    ci.kingDanger = (checkers ? generateKingDanger<wtm>(gs) : 0x0ULL);
+    computePins<wtm>(gs, ci);
+    return ci;
+}
+
+/******************************************************************************
+ * Function that generates the legal moves of the kind given by 'type' while
+ * the side to move is in check.
  *
  * Short outline of the procedure:
- * 	- generate the 'kingDanger', all squares attacked by the enemy
  * 	- generate non-castling king moves
- * 	- if in check:
- * 		- double check -> movegen done, only king moves possible
- * 		- single check -> set special check evasion masks
- * 	- detect pinned pieces
+ * 	- double check -> done, only king moves possible
+ * 	- single check -> capture the checker or block its ray, with any
+ * 		piece that is not pinned (a pinned piece can never resolve a
+ * 		check, it can only move along the line to its own king)
  */
-void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
-							    bool& inCheck) {
-    inCheck = false;
+template <bool wtm, GenType type, typename List>
+static void generateEvasionMoves(const GameState& gs, const CheckInfo& ci,
+							    List& movelist) {
+    constexpr bool noQuiets = (type == GenType::noisy
+			       or type == GenType::tactical);
+
+    const Board& b = gs.board;
+    const bitb enemies = (wtm ? b.black() : b.white());
+    const bitb ownKing = (wtm ? b.wKing() : b.bKing());
+    const int ownKingIndex = BSF(ownKing);
+
+    ///////////////////////////////////////////////////////
+    //                     king moves                    //
+    ///////////////////////////////////////////////////////
+    const bitb kingAtks = kingAttacks[ownKingIndex] & ~ci.kingDanger;
+    if constexpr (type != GenType::quiets)
+	addMoves(movelist, ownKingIndex, kingAtks & enemies, true);
+    if constexpr (not noQuiets)
+	addMoves(movelist, ownKingIndex, kingAtks & ~b.occ, false);
+
+    ///////////////////////////////////////////////////////
+    //                      checker                      //
+    ///////////////////////////////////////////////////////
+    const bitb checker = ci.checkers;
+    if (checker & (checker - 1)) return; // double check, we are done
+
+    // we may always capture the checking piece, sliders may also be blocked
+    // (knights and adjacent pieces have no squares in between)
+    bitb captureMask = checker;
+    const bitb blockMask = between[ownKingIndex][BSF(checker)];
+
+    // only keep the kind of moves that was asked for
+    constexpr bitb promoRanks = 0xff000000000000ffULL;
+    bitb pushMask = blockMask;
+    bitb pawnPushMask = blockMask;
+    if constexpr (noQuiets) {
+	pushMask = 0x0ULL;
+	pawnPushMask &= promoRanks;
+    }
+    if constexpr (type == GenType::quiets) {
+	captureMask = 0x0ULL;
+	pawnPushMask &= ~promoRanks;
+    }
+
+    const bitb pinned = ci.latPinned | ci.diaPinned;
+
+    ///////////////////////////////////////////////////////
+    //                      pieces                       //
+    ///////////////////////////////////////////////////////
+    const bitb ownQueens = (wtm ? b.wQueens() : b.bQueens());
+    bitb ownKnights = (wtm ? b.wKnights() : b.bKnights()) & ~pinned;
+    bitb ownRooklike = ((wtm ? b.wRooks() : b.bRooks()) | ownQueens) & ~pinned;
+    bitb ownBishoplike = ((wtm ? b.wBishops() : b.bBishops()) | ownQueens)
+								& ~pinned;
+    while (ownKnights) {
+	const int from = BSF(ownKnights);
+	ownKnights &= ownKnights - 1;
+	const bitb atks = knightAttacks[from];
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
+    }
+    while (ownRooklike) {
+	const int from = BSF(ownRooklike);
+	ownRooklike &= ownRooklike - 1;
+	const bitb atks = rookAttacks(b.occ, from);
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
+    }
+    while (ownBishoplike) {
+	const int from = BSF(ownBishoplike);
+	ownBishoplike &= ownBishoplike - 1;
+	const bitb atks = bishopAttacks(b.occ, from);
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
+    }
+
+    ///////////////////////////////////////////////////////
+    //                       pawns                       //
+    ///////////////////////////////////////////////////////
+    constexpr bitb aFile = 0x8080808080808080ULL;
+    constexpr bitb hFile = 0x101010101010101ULL;
+    constexpr bitb rank3 = 0xff0000ULL;
+    constexpr bitb rank6 = 0xff0000000000ULL;
+    const bitb ownPawns = (wtm ? b.wPawns() : b.bPawns()) & ~pinned;
+    // direction of a push and of both captures
+    constexpr int up = (wtm ? 8 : -8);
+    constexpr int left = (wtm ? 9 : -7);
+    constexpr int right = (wtm ? 7 : -9);
+
+    // single and double pushes (only to block)
+    const bitb singles = shift<up>(ownPawns) & ~b.occ;
+    const bitb pushes = singles & pawnPushMask;
+    const bitb doubles = shift<up>(singles & (wtm ? rank3 : rank6))
+		       & ~b.occ & pushMask;
+    addPawnMoves<up>(movelist, pushes & ~promoRanks, false);
+    addPawnPromotions<type, up>(movelist, pushes & promoRanks, false);
+    addDoublePushes<up>(movelist, doubles);
+
+    // captures of the checker
+    const bitb leftAtks = shift<left>(ownPawns & ~aFile) & captureMask;
+    const bitb rightAtks = shift<right>(ownPawns & ~hFile) & captureMask;
+    addPawnMoves<left>(movelist, leftAtks & ~promoRanks, true);
+    addPawnMoves<right>(movelist, rightAtks & ~promoRanks, true);
+    addPawnPromotions<type, left>(movelist, leftAtks & promoRanks, true);
+    addPawnPromotions<type, right>(movelist, rightAtks & promoRanks, true);
+
+    // En passant only resolves the check if the double pushed pawn is the
+    // checker. The capturing pawn can not be part of a horizontal pin then,
+    // the king can not stand on the rank of both pawns.
+    if (gs.epTarget != -1) {
+	const int pawnToCaptureIndex = gs.epTarget - up;
+	if ((1ULL << pawnToCaptureIndex) & captureMask) {
+	    bitb capturers = ownPawns & pawnAttacks<!wtm>(1ULL << gs.epTarget);
+	    while (capturers) {
+		const int from = BSF(capturers);
+		capturers &= capturers - 1;
+		movelist.push_back(Move(from, gs.epTarget, true, false, true,
+							false, false, ' '));
+	    }
+	}
+    }
+} // end of generateEvasionMoves
+
+/******************************************************************************
+ * Function that generates the legal moves of the kind given by 'type' in a
+ * given position for the side 'wtm', returns them on 'movelist'.
+ *
+ * Short outline of the procedure:
+ * 	- if in check -> 'generateEvasionMoves', done
+ * 	- generate non-castling king moves (using the 'kingDanger', all
+ * 		squares attacked by the enemy)
+ * 	- move pinned pieces only along their pin lines
+ *
+ * The kind of moves is selected by restricting the capture and push masks,
+ * so all three kinds share the same code.
+ *
+ * If 'legal' is false the moves are pseudo-legal: pins and attacked squares
+ * (king moves, castling and the en passant special cases) are ignored and
+ * left to 'isLegal'. The king danger of 'ci' is not used then. Evasions are
+ * always legal.
+ */
+template <bool wtm, GenType type, bool legal, typename List>
+static void generateSideMoves(const GameState& gs, const CheckInfo& ci,
+							    List& movelist) {
+    // no quiet moves at all (except queen promotions)
+    constexpr bool noQuiets = (type == GenType::noisy
+			       or type == GenType::tactical);
 
     // reset movelist
-    movelist.resize(0);
+    movelist.clear();
 
     // reference to board
     const Board& b = gs.board;
 
-    // white to move
-    const bool wtm = gs.whiteToMove;
+    const bitb enemies = (wtm ? b.black() : b.white());
 
-    const bitb enemies = (wtm ? b.black : b.white);
+    const bitb kingDanger = ci.kingDanger;
 
-    // calculate king danger
-    const bitb kingDanger = generateKingDanger(gs);
+    // in check -> dedicated evasion generator
+    if (ci.checkers) {
+	generateEvasionMoves<wtm, type>(gs, ci, movelist);
+	return;
+    }
+
+    const bitb ownKing = (wtm ? b.wKing() : b.bKing());
 
     ///////////////////////////////////////////////////////
     //                     king moves                    //
     ///////////////////////////////////////////////////////
     // calculate king moves, no castle moves yet
-    const bitb ownKing = (wtm ? b.wKing : b.bKing);
     const int ownKingIndex = BSF(ownKing);
     // all squares that the king attacks
     const bitb kingAtks = kingAttacks[ownKingIndex];
+    // squares the king may move to without being in check afterwards
+    const bitb kingSafe = (legal ? ~kingDanger : ~0x0ULL);
     // king can push to all squares that are not occupied and not in danger
-    bitb kingPushes = kingAtks & ~kingDanger & ~b.occ;
+    bitb kingPushes = kingAtks & kingSafe & ~b.occ;
     // king can capture on all squares occupied by enemies and not in danger
-    bitb kingCaptures = kingAtks & enemies & ~kingDanger;
-    
-    // add king moves to movelist
-    while (kingCaptures) { // captures
-	const int to = BSF(kingCaptures);
-	movelist.push_back(Move(ownKingIndex, to, true, false, false,
-						  false, false, ' '));
-	kingCaptures &= kingCaptures - 1;
-    }
-    while (kingPushes) { // quiet moves
-	const int to = BSF(kingPushes);
-	movelist.push_back(Move(ownKingIndex, to, false, false, false,
-						  false, false, ' '));
-	kingPushes &= kingPushes - 1;
-    }
+    bitb kingCaptures = kingAtks & enemies & kingSafe;
+    if constexpr (noQuiets) kingPushes = 0x0ULL;
+    if constexpr (type == GenType::quiets) kingCaptures = 0x0ULL;
+
+    // add king moves to movelist, captures first
+    addMoves(movelist, ownKingIndex, kingCaptures, true);
+    addMoves(movelist, ownKingIndex, kingPushes, false);
 
     ///////////////////////////////////////////////////////
-    //                       checks                      //
+    //                    move masks                     //
     ///////////////////////////////////////////////////////
     // Define a 'pushMask', all the square where we may move a piece without
     // a capture and a 'captureMask', all the square where we may capture on.
-    // If we are not in check both mask consist of all squares on the board.
+    // As we are not in check both mask consist of all squares on the board.
     bitb pushMask = 0xffffffffffffffffULL;
     bitb captureMask = 0xffffffffffffffffULL;
 
-    // enemy pieces by type
-    const bitb enemyPawns = (wtm ? b.bPawns : b.wPawns);
-    const bitb enemyKnights = (wtm ? b.bKnights : b.wKnights);
-    const bitb enemyBishops = (wtm ? b.bBishops : b.wBishops);
-    const bitb enemyRooks = (wtm ? b.bRooks : b.wRooks);
-    const bitb enemyQueens = (wtm ? b.bQueens : b.wQueens);
-    const bitb enemyRooklikeSlider = enemyRooks | enemyQueens;
-    const bitb enemyBishoplikeSlider = enemyBishops | enemyQueens;
-
-    // test if we are in check at all by looking at the king danger
-    if (ownKing & kingDanger) {
-	inCheck = true;
-	// We are in check... If it's double check we can immediatly leaf the
-	// move generation, as double check only allows for non-castling king
-	// moves. If it's a single check we have the options to capture the
-	// checking piece (handled by the 'captureMask') or to block the check
-	// in the case of a slider (handled by the 'pushMask').
-	const bitb pawnChecker = enemyPawns & pawnAttacks(wtm, ownKing);
-	const bitb knightChecker = enemyKnights & knightAttacks[ownKingIndex];
-	const bitb diagChecker
-	    = enemyBishoplikeSlider & bishopAttacks(b.occ, ownKingIndex);
-	const bitb lateralChecker
-	    = enemyRooklikeSlider & rookAttacks(b.occ, ownKingIndex);
-
-	// all checker
-	const bitb checker = pawnChecker | knightChecker
-			    | diagChecker | lateralChecker;
-	const int nChecker = POP(checker); // number of pieces giving check
-					   
-	if (nChecker > 1) return; // double check, we are done
-	// seems like we are only checked by a single piece
-	captureMask = checker; // we may always capture the checking piece
-	// 'pushMask' is empty unless it's a sliding piece giving check
-	pushMask = 0x0ULL;
-	if (diagChecker) { // bishop or queen
-	    const bitb kingRays = bishopAttacks(b.occ, ownKingIndex);
-	    const bitb checkerRays = bishopAttacks(b.occ, BSF(diagChecker));
-	    pushMask = kingRays & checkerRays;
-	} else if (lateralChecker) { // rook or queen
-	    const bitb kingRays = rookAttacks(b.occ, ownKingIndex);
-	    const bitb checkerRays = rookAttacks(b.occ, BSF(lateralChecker));
-	    pushMask = kingRays & checkerRays;
-	}
-    } // end of 'inCheck' section
+    // enemy sliders, needed for the en passant special cases
+    const bitb enemyRooklikeSlider = (wtm ? (b.bRooks() | b.bQueens())
+					  : (b.wRooks() | b.wQueens()));
+    const bitb enemyBishoplikeSlider = (wtm ? (b.bBishops() | b.bQueens())
+					    : (b.wBishops() | b.wQueens()));
     
     // adjust capture mask to only include actual enemy pieces
     captureMask &= enemies;
     // adjust push mask to only include empty squares
     pushMask &= ~b.occ;
 
+    // only keep the kind of moves that was asked for, captures and
+    // promotions are noisy, everything else is quiet
+    constexpr bitb promoRanks = 0xff000000000000ffULL;
+    bitb pawnPushMask = pushMask;
+    if constexpr (noQuiets) {
+	pushMask = 0x0ULL;
+	pawnPushMask &= promoRanks;
+    }
+    if constexpr (type == GenType::quiets) {
+	captureMask = 0x0ULL;
+	pawnPushMask &= ~promoRanks;
+    }
+
     ///////////////////////////////////////////////////////
     //                  pinned pieces                    //
     ///////////////////////////////////////////////////////
-    // detect all pinned pieces, differentiate between horizontal/vertical
-    // pins and diagonal/antidiagonal pins
-    bitb latPinned = detectLaterallyPinnedPieces(gs);
-    bitb diaPinned = detectDiagonallyPinnedPieces(gs);
-    bitb pinned = latPinned | diaPinned;
+    // differentiate between horizontal/vertical pins and diagonal/
+    // antidiagonal pins (pseudo-legal moves ignore them)
+    const bitb latPinned = (legal ? ci.latPinned : 0x0ULL);
+    const bitb diaPinned = (legal ? ci.diaPinned : 0x0ULL);
+    const bitb pinned = latPinned | diaPinned;
 
     ///////////////////////////////////////////////////////
     //                      queens                       //
     ///////////////////////////////////////////////////////
     // queens are just handled together with rooks and bishops
-    const bitb ownQueens = (b.wQueens | b.bQueens) & ~enemies;
+    const bitb ownQueens = (wtm ? b.wQueens() : b.bQueens());
 
     ///////////////////////////////////////////////////////
     //                       rooks                       //
     ///////////////////////////////////////////////////////
-    bitb ownRooks = (b.wRooks | b.bRooks) & ~enemies;
+    bitb ownRooks = (wtm ? b.wRooks() : b.bRooks());
     ownRooks |= ownQueens;
     // pinned rooks... diagonally pinned rooks can never move...
     // laterally rooks need special care
@@ -153,54 +476,24 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
 	const int from = BSF(ownRooks);
 	ownRooks &= ownRooks - 1;
 	const bitb atks = rookAttacks(b.occ, from);
-	bitb pushes = atks & pushMask;
-	bitb captures = atks & captureMask;
 	// add moves to movelist, captures first
-	while (captures) {
-	    const int to = BSF(captures);
-	    captures &= captures - 1;
-	    movelist.push_back(Move(from, to, true, false, false,
-						false, false, ' '));
-	}
-	while (pushes) {
-	    const int to = BSF(pushes);
-	    pushes &= pushes - 1;
-	    movelist.push_back(Move(from, to, false, false, false,
-						false, false, ' '));
-	}
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
     }
-    // for pinned rooks the rooklike attacks of the king on an empty board are
-    // calculated, as well as the rooks true attacks. Both are combined with a
-    // bitwise AND to obtain the final square the piece can move to.
+    // pinned rooks may only move along the line through king and rook
     while (pinnedRooks) {
-	const bitb kingRays = rookAttacks(0x0ULL, ownKingIndex); // this could
-								 // be move out
-								 // of the loop
 	const int from = BSF(pinnedRooks);
 	pinnedRooks &= pinnedRooks - 1;
-	const bitb pieceRays = rookAttacks(b.occ, from);
-	const bitb atks = pieceRays & kingRays;
-	bitb pushes = atks & pushMask;
-	bitb captures = atks & captureMask;
+	const bitb atks = rookAttacks(b.occ, from) & line[ownKingIndex][from];
 	// add moves to movelist, captures first
-	while (captures) {
-	    const int to = BSF(captures);
-	    captures &= captures - 1;
-	    movelist.push_back(Move(from, to, true, false, false,
-						false, false, ' '));
-	}
-	while (pushes) {
-	    const int to = BSF(pushes);
-	    pushes &= pushes - 1;
-	    movelist.push_back(Move(from, to, false, false, false,
-						false, false, ' '));
-	}
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
     }
 
     ///////////////////////////////////////////////////////
     //                      bishops                      //
     ///////////////////////////////////////////////////////
-    bitb ownBishops = (b.wBishops | b.bBishops) & ~enemies;
+    bitb ownBishops = (wtm ? b.wBishops() : b.bBishops());
     ownBishops |= ownQueens;
     // pinned bishops... laterally pinned bishops can never move...
     // diagonally pinned bishops need special care
@@ -210,491 +503,115 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
 	const int from = BSF(ownBishops);
 	ownBishops &= ownBishops - 1;
 	const bitb atks = bishopAttacks(b.occ, from);
-	bitb pushes = atks & pushMask;
-	bitb captures = atks & captureMask;
 	// add moves to movelist, captures first
-	while (captures) {
-	    const int to = BSF(captures);
-	    captures &= captures - 1;
-	    movelist.push_back(Move(from, to, true, false, false,
-						false, false, ' '));
-	}
-	while (pushes) {
-	    const int to = BSF(pushes);
-	    pushes &= pushes - 1;
-	    movelist.push_back(Move(from, to, false, false, false,
-						false, false, ' '));
-	}
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
     }
-    // for pinned bishops the bishoplike attacks of the king on an empty board
-    // are calculated, as well as the bishops true attacks. Both are combined
-    // with a bitwise AND to obtain the final square the piece can move to.
+    // pinned bishops may only move along the line through king and bishop
     while (pinnedBishops) {
-	const bitb kingRays = bishopAttacks(0x0ULL, ownKingIndex); //this could
-								 // be move out
-								 // of the loop
 	const int from = BSF(pinnedBishops);
 	pinnedBishops &= pinnedBishops - 1;
-	const bitb pieceRays = bishopAttacks(b.occ, from);
-	const bitb atks = pieceRays & kingRays;
-	bitb pushes = atks & pushMask;
-	bitb captures = atks & captureMask;
+	const bitb atks
+	    = bishopAttacks(b.occ, from) & line[ownKingIndex][from];
 	// add moves to movelist, captures first
-	while (captures) {
-	    const int to = BSF(captures);
-	    captures &= captures - 1;
-	    movelist.push_back(Move(from, to, true, false, false,
-						false, false, ' '));
-	}
-	while (pushes) {
-	    const int to = BSF(pushes);
-	    pushes &= pushes - 1;
-	    movelist.push_back(Move(from, to, false, false, false,
-						false, false, ' '));
-	}
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
     }
 
     ///////////////////////////////////////////////////////
     //                      knights                      //
     ///////////////////////////////////////////////////////
-    bitb ownKnights = (b.wKnights | b.bKnights) & ~enemies;
+    bitb ownKnights = (wtm ? b.wKnights() : b.bKnights());
     // pinned knights can never move
     ownKnights &= ~pinned;
     while (ownKnights) {
 	const int from = BSF(ownKnights);
 	ownKnights &= ownKnights - 1;
 	const bitb atks = knightAttacks[from];
-	bitb pushes = atks & pushMask;
-	bitb captures = atks & captureMask;
 	// add moves to movelist, captures first
-	while (captures) {
-	    const int to = BSF(captures);
-	    captures &= captures - 1;
-	    movelist.push_back(Move(from, to, true, false, false,
-						false, false, ' '));
-	}
-	while (pushes) {
-	    const int to = BSF(pushes);
-	    pushes &= pushes - 1;
-	    movelist.push_back(Move(from, to, false, false, false,
-						false, false, ' '));
-	}
+	addMoves(movelist, from, atks & captureMask, true);
+	addMoves(movelist, from, atks & pushMask, false);
     }
 
     ///////////////////////////////////////////////////////
     //                       pawns                       //
     ///////////////////////////////////////////////////////
-    // TODO: The pawn section is very shitty, should be fixed at some point...
-    // pushes
-    constexpr bitb rank2 = 0xff00ULL;
-    constexpr bitb rank7 = 0xff000000000000ULL;
-    // white pawns
-    if (gs.whiteToMove) {
-	bitb ownPawns = b.wPawns;
-	// diagonally pinned pawns can never push
-	ownPawns &= ~diaPinned;
-	// take laterally pinned pawns for later
-	bitb pinnedPawns = ownPawns & latPinned;
-	// let only non-pinned pawns remain
-	ownPawns &= ~latPinned;
-	bitb pushes = ownPawns << 8; // push
-	bitb freePushes = pushes & ~b.occ; // free?
-	freePushes &= pushMask; // on pushMask?
-	while (freePushes) {
-	    const int to = BSF(freePushes);
-	    freePushes &= freePushes - 1;
-	    if (to>55) { // promotion!
-		movelist.push_back(Move(to-8, to, false, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to-8, to, false, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to-8, to, false, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to-8, to, false, false, false,
-						    false, true, 'b'));
-
-	    } else {
-		movelist.push_back(Move(to-8, to, false, false, false,
-						    false, false, ' '));
-	    }
-	}
-
-	// double pawn pushes...
-	// push the pawns from the 2nd rank once, then check if this push was
-	// not occupied. If so push again, check if free and check if in push-
-	// mask
-	bitb freeDoublePushes = (ownPawns & rank2) << 8; // first push
-	freeDoublePushes &= ~b.occ; // free?
-	freeDoublePushes = freeDoublePushes << 8; // second push
-	freeDoublePushes &= ~b.occ; // free?
-	freeDoublePushes &= pushMask; // second push on pushMask?
-	while (freeDoublePushes) {
-	    const int to = BSF(freeDoublePushes);
-	    freeDoublePushes &= freeDoublePushes - 1;
-	    movelist.push_back(Move(to-16, to, false, true, false,
-						false, false, ' '));
-	}
-
-	// pinned pawns
-	// so... these are either vertically or horizontally pinned...
-	// they can never promote.
-	// they can not push if the pin is horizontal
-	while (pinnedPawns) {
-	    const int from = BSF(pinnedPawns);
-	    pinnedPawns &= pinnedPawns - 1;
-	    // check for horizontal pin
-	    if (from/8 == ownKingIndex/8) continue;
-	    // so this pawn in vertically pinned, this means it can just move
-	    // normally, respecting the push mask
-	    bitb pawnMask = (1ULL << from);
-	    bitb singlePush = (pawnMask << 8) & ~b.occ & pushMask;
-	    if (singlePush) {
-		movelist.push_back(Move(from, from+8, false, false, false,
-						    false, false, ' '));
-	    }
-	    if (from < 16) // pawn on starting rank
-	    if ((pawnMask << 8) & ~b.occ) { // single push is free
-		const int to = from + 16;
-		if ((1ULL << to) & ~b.occ & pushMask) // double push allowed
-		movelist.push_back(Move(to-16, to, false, true, false,
-						    false, false, ' '));
-	    }
-	}
-
-    // black pawns
-    } else {
-	bitb ownPawns = b.bPawns;
-	// diagonally pinned pawns can never push
-	ownPawns &= ~diaPinned;
-	// take laterally pinned pawns for later
-	bitb pinnedPawns = ownPawns & latPinned;
-	// let only non-pinned pawns remain
-	ownPawns &= ~latPinned;
-	bitb pushes = ownPawns >> 8; // push
-	bitb freePushes = pushes & ~b.occ; // free?
-	freePushes &= pushMask; // on pushMask?
-	while (freePushes) {
-	    const int to = BSF(freePushes);
-	    freePushes &= freePushes - 1;
-	    if (to<8) { // promotion!
-		movelist.push_back(Move(to+8, to, false, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to+8, to, false, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to+8, to, false, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to+8, to, false, false, false,
-						    false, true, 'b'));
-
-	    } else {
-		movelist.push_back(Move(to+8, to, false, false, false,
-						    false, false, ' '));
-	    }
-	}
-
-	// double pawn pushes...
-	// push the pawns from the 7th rank once, then check if this push was
-	// not occupied. If so push again, check if free and check if in push-
-	// mask
-	bitb freeDoublePushes = (ownPawns & rank7) >> 8; // first push
-	freeDoublePushes &= ~b.occ; // free?
-	freeDoublePushes = freeDoublePushes >> 8; // second push
-	freeDoublePushes &= ~b.occ; // free?
-	freeDoublePushes &= pushMask; // second push on pushMask?
-	while (freeDoublePushes) {
-	    const int to = BSF(freeDoublePushes);
-	    freeDoublePushes &= freeDoublePushes - 1;
-	    movelist.push_back(Move(to+16, to, false, true, false,
-						false, false, ' '));
-	}
-
-	// pinned pawns
-	// so... these are either vertically or horizontally pinned...
-	// they can never promote.
-	// they can not push if the pin is horizontal
-	while (pinnedPawns) {
-	    const int from = BSF(pinnedPawns);
-	    pinnedPawns &= pinnedPawns - 1;
-	    // check for horizontal pin
-	    if (from/8 == ownKingIndex/8) continue;
-	    // so this pawn in vertically pinned, this means it can just move
-	    // normally, respecting the push mask
-	    bitb pawnMask = (1ULL << from);
-	    bitb singlePush = (pawnMask >> 8) & ~b.occ & pushMask;
-	    if (singlePush) {
-		movelist.push_back(Move(from, from-8, false, false, false,
-						    false, false, ' '));
-	    }
-	    if (from > 47) // pawn on starting rank
-	    if ((pawnMask >> 8) & ~b.occ) { // single push is free
-		const int to = from - 16;
-		if ((1ULL << to) & ~b.occ & pushMask) // double push allowed
-		movelist.push_back(Move(to+16, to, false, true, false,
-						    false, false, ' '));
-	    }
-	}
-    }
-
-    // pawn captures, oh boi...
+    // All pawns are moved at once by shifting the whole bitboard. A pinned
+    // pawn may only move along the line through its king and its pinner, so
+    // for every direction the pinned pawns off the matching line of the king
+    // are filtered out before the shift.
+    // directions (relative to the side to move) of a push and both captures
+    constexpr int up = (wtm ? 8 : -8);
+    constexpr int left = (wtm ? 9 : -7);
+    constexpr int right = (wtm ? 7 : -9);
     constexpr bitb aFile = 0x8080808080808080ULL;
     constexpr bitb hFile = 0x101010101010101ULL;
+    // rank of the single push of a pawn on its starting rank
+    constexpr bitb doublePushRank = (wtm ? 0xff0000ULL : 0xff0000000000ULL);
 
-    // white pawns (captures)
-    if (gs.whiteToMove) {
-	bitb ownPawns = b.wPawns & ~pinned;
-	bitb pinnedPawns = b.wPawns & diaPinned;
-	// capture to the left (nw, <<9) so no pawns from the a file
-	bitb leftAtks = (ownPawns & ~aFile) << 9;
-	leftAtks &= captureMask;
-	while (leftAtks) {
-	    const int to = BSF(leftAtks);
-	    leftAtks &= leftAtks - 1;
-	    if (to>55) { // promotion!
-		movelist.push_back(Move(to-9, to, true, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to-9, to, true, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to-9, to, true, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to-9, to, true, false, false,
-						    false, true, 'b'));
-	    } else {
-		movelist.push_back(Move(to-9, to, true, false, false,
-						    false, false, ' '));
-	    }
-	}
-	// capture to the right (ne, <<7) so no pawns from the h file
-	bitb rightAtks = (ownPawns & ~hFile) << 7;
-	rightAtks &= captureMask;
-	while (rightAtks) {
-	    const int to = BSF(rightAtks);
-	    rightAtks &= rightAtks - 1;
-	    if (to>55) { // promotion!
-		movelist.push_back(Move(to-7, to, true, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to-7, to, true, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to-7, to, true, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to-7, to, true, false, false,
-						    false, true, 'b'));
-	    } else {
-		movelist.push_back(Move(to-7, to, true, false, false,
-						    false, false, ' '));
-	    }
-	}
-	// now handle the pinned pawns
-	while (pinnedPawns) {
-	    const int from = BSF(pinnedPawns);
-	    pinnedPawns &= pinnedPawns - 1;
-	    // pinned along a diagonal
-	    if (diags[from] == diags[ownKingIndex]) {
-		// here we can capture to the left, so +9
-		const int to = from + 9;
-		if ((1ULL<<to) & captureMask) {
-		    if (to>55) { // promotion
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'q'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'n'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'r'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'b'));
-		    } else {
-			movelist.push_back(Move(from, to, true, false, false,
-							false, false, ' '));
-		    }
-		}
-	    // pinned along a antidiagonal
-	    } else if (antidiags[from] == antidiags[ownKingIndex]) {
-		// here we can capture to the right, so +7
-		const int to = from + 7;
-		if ((1ULL<<to) & captureMask) {
-		    if (to>55) { // promotion
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'q'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'n'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'r'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'b'));
-		    } else {
-			movelist.push_back(Move(from, to, true, false, false,
-							false, false, ' '));
-		    }
-		}
-	    }
-	}
+    // lines through the king, a pawn pinned along one of them stays on it
+    const bitb kingFile = hFile << (ownKingIndex % 8);
+    const bitb kingDiag = nwRays[ownKingIndex] | seRays[ownKingIndex];
+    const bitb kingAntidiag = neRays[ownKingIndex] | swRays[ownKingIndex];
 
-    // black pawns (captures)
-    } else {
-	bitb ownPawns = b.bPawns & ~pinned;
-	bitb pinnedPawns = b.bPawns & diaPinned;
-	// capture to the left (sw, >>7) so no pawns from the a file
-	bitb leftAtks = (ownPawns & ~aFile) >> 7;
-	leftAtks &= captureMask;
-	while (leftAtks) {
-	    const int to = BSF(leftAtks);
-	    leftAtks &= leftAtks - 1;
-	    if (to<8) { // promotion!
-		movelist.push_back(Move(to+7, to, true, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to+7, to, true, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to+7, to, true, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to+7, to, true, false, false,
-						    false, true, 'b'));
-	    } else {
-		movelist.push_back(Move(to+7, to, true, false, false,
-						    false, false, ' '));
-	    }
-	}
-	// capture to the right (ne, >>9) so no pawns from the h file
-	bitb rightAtks = (ownPawns & ~hFile) >> 9;
-	rightAtks &= captureMask;
-	while (rightAtks) {
-	    const int to = BSF(rightAtks);
-	    rightAtks &= rightAtks - 1;
-	    if (to<8) { // promotion!
-		movelist.push_back(Move(to+9, to, true, false, false,
-						    false, true, 'q'));
-		movelist.push_back(Move(to+9, to, true, false, false,
-						    false, true, 'n'));
-		movelist.push_back(Move(to+9, to, true, false, false,
-						    false, true, 'r'));
-		movelist.push_back(Move(to+9, to, true, false, false,
-						    false, true, 'b'));
-	    } else {
-		movelist.push_back(Move(to+9, to, true, false, false,
-						    false, false, ' '));
-	    }
-	}
-	// now handle the pinned pawns
-	while (pinnedPawns) {
-	    const int from = BSF(pinnedPawns);
-	    pinnedPawns &= pinnedPawns - 1;
-	    // pinned along a diagonal
-	    if (diags[from] == diags[ownKingIndex]) {
-		// here we can capture to the right, so -9
-		const int to = from - 9;
-		if ((1ULL<<to) & captureMask) {
-		    if (to>55) { // promotion
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'q'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'n'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'r'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'b'));
-		    } else {
-			movelist.push_back(Move(from, to, true, false, false,
-							false, false, ' '));
-		    }
-		}
-	    // pinned along a antidiagonal
-	    } else if (antidiags[from] == antidiags[ownKingIndex]) {
-		// here we can capture to the left, so -7
-		const int to = from - 7;
-		if ((1ULL<<to) & captureMask) {
-		    if (to>55) { // promotion
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'q'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'n'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'r'));
-			movelist.push_back(Move(from, to, true, false, false,
-							false, true, 'b'));
-		    } else {
-			movelist.push_back(Move(from, to, true, false, false,
-							false, false, ' '));
-		    }
-		}
-	    }
-	}
-    }
+    const bitb ownPawns = (wtm ? b.wPawns() : b.bPawns());
+    const bitb pushers = ownPawns & (~pinned | kingFile);
+    const bitb leftCapturers
+	= ownPawns & ~aFile & (~pinned | (wtm ? kingDiag : kingAntidiag));
+    const bitb rightCapturers
+	= ownPawns & ~hFile & (~pinned | (wtm ? kingAntidiag : kingDiag));
 
-    // all en passant captures are handled here
-    if (gs.epTarget != -1) {
-	// check if the pawn in question may be captures at all...
-	// If the enemy pawn is pinned to our king diagonally we may never
-	// ep cature it. (by the definition used here it can not be laterally
-	// pinned, this is not completely true but will be handled later)
-	const bitb pawnToCaptureIndex
-			= (gs.whiteToMove ? gs.epTarget-8 : gs.epTarget+8);
-	if ((1ULL<<pawnToCaptureIndex) & diaPinned) {
-	    // cannot be captured
-	    goto noEP;
-	}
-	// if pawn is not in captureMask also done
-	if (not ((1ULL<<pawnToCaptureIndex) & captureMask)) {
-	    // cannot be captured
-	    goto noEP;
-	}
+    // pushes
+    const bitb singles = shift<up>(pushers) & ~b.occ;
+    const bitb doubles
+	= shift<up>(singles & doublePushRank) & ~b.occ & pawnPushMask;
+    const bitb pushes = singles & pawnPushMask;
+    addPawnMoves<up>(movelist, pushes & ~promoRanks, false);
+    addPawnPromotions<type, up>(movelist, pushes & promoRanks, false);
+    addDoublePushes<up>(movelist, doubles);
 
-	const bitb potentialPawns
-			= pawnAttacks(!gs.whiteToMove, (1ULL<<gs.epTarget));
-	bitb ownPawns = (gs.whiteToMove ? b.wPawns : b.bPawns);
-	ownPawns &= potentialPawns;
-	// diagonally pinned pawns for later
-	bitb diaPinnedPawns = ownPawns & diaPinned;
-	// laterally pinned pawns can never capture
-	ownPawns &= ~pinned;
-	while(ownPawns) {
-	    const int from = BSF(ownPawns);
-	    ownPawns &= ownPawns - 1;
-	    // rook  pawn  pawn  king arragement
-	    // test if its even possible
-	    const bitb specialRank
-	    		= (gs.whiteToMove ? 0xff00000000ULL : 0xff000000ULL);
-	    if (ownKing & specialRank) { // is my king even on the right rank?
-	        bitb potentialRooks = enemyRooklikeSlider & specialRank;
-	        if (potentialRooks) { // also a rook/queen?
-	    	   // mask with only both pawns in question
-	    	   const bitb bothPawns
-		   		= (1ULL<<pawnToCaptureIndex) | (1ULL<<from);
-	    	   while(potentialRooks) {
-	    	       const int index = BSF(potentialRooks);
-	    	       potentialRooks &= potentialRooks - 1;
-		       bitb overlap = (wRays[ownKingIndex] & eRays[index])
-					| (eRays[ownKingIndex] & wRays[index]);
-		       overlap &= b.occ;
-		       if (overlap == bothPawns) goto noEP;
-	    	   }
-	        }
-	    }
-	    movelist.push_back(Move(from, gs.epTarget, true, false, true,
+    // captures
+    const bitb leftAtks = shift<left>(leftCapturers) & captureMask;
+    const bitb rightAtks = shift<right>(rightCapturers) & captureMask;
+    addPawnMoves<left>(movelist, leftAtks & ~promoRanks, true);
+    addPawnMoves<right>(movelist, rightAtks & ~promoRanks, true);
+    addPawnPromotions<type, left>(movelist, leftAtks & promoRanks, true);
+    addPawnPromotions<type, right>(movelist, rightAtks & promoRanks, true);
+
+    // En passant, the captured pawn has to be a legal capture target and
+    // must not shield the king from a bishoplike slider itself.
+    if (gs.epTarget != -1) {
+	const bitb epMask = (1ULL << gs.epTarget);
+	const bitb capturedMask = shift<-up>(epMask);
+	if ((capturedMask & captureMask)
+		and not (legal
+		    and (bishopAttacks(b.occ ^ capturedMask, ownKingIndex)
+						& enemyBishoplikeSlider))) {
+	    bitb capturers = (leftCapturers & shift<-left>(epMask))
+			   | (rightCapturers & shift<-right>(epMask));
+	    // Dedicated horizontal pin check: both pawns leave the rank at
+	    // once, which may expose the king to a rooklike slider.
+	    constexpr bitb epRank = (wtm ? 0xff00000000ULL : 0xff000000ULL);
+	    const bitb rankSliders = enemyRooklikeSlider & epRank;
+	    while (capturers) {
+		const int from = BSF(capturers);
+		capturers &= capturers - 1;
+		if (legal and (ownKing & epRank) and rankSliders) {
+		    const bitb occAfter = b.occ ^ (1ULL << from) ^ capturedMask;
+		    if (rookAttacks(occAfter, ownKingIndex) & rankSliders)
+			continue;
+		}
+		movelist.push_back(Move(from, gs.epTarget, true, false, true,
 							false, false, ' '));
-	}
-	// dia pinned pawns here
-	while(diaPinnedPawns) {
-	    const int from = BSF(diaPinnedPawns);
-	    diaPinnedPawns &= diaPinnedPawns - 1;
-	    // same diagonal
-	    if (diags[from] == diags[ownKingIndex]
-		and diags[from] == diags[gs.epTarget]) {
-		     movelist.push_back(
-			     Move(from, gs.epTarget, true, false, true,
-						    false, false, ' '));
-	    // same antidiagonal
-	    } else if (antidiags[from] == antidiags[ownKingIndex]
-		    and antidiags[from] == antidiags[gs.epTarget]) {
-		     movelist.push_back(
-			     Move(from, gs.epTarget, true, false, true,
-						    false, false, ' '));
 	    }
 	}
     }
-    noEP:
 
     ///////////////////////////////////////////////////////
     //                      castling                     //
     ///////////////////////////////////////////////////////
-    if (wtm) { // white
+    if constexpr (noQuiets) return;
+    if constexpr (wtm) { // white
 	// white kingside
 	if (gs.whiteShort) {
     	    constexpr bitb wsOccMask = 0x6ULL;
@@ -702,7 +619,8 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
     	    // are f1 and g1 free?
     	    const bool isFree = (wsOccMask & ~b.occ) == wsOccMask;
     	    // are e1, f1 and g1 safe?
-	    const bool isSafe = (wsDangerMask & ~kingDanger) == wsDangerMask;
+	    const bool isSafe
+		= not legal or ((wsDangerMask & ~kingDanger) == wsDangerMask);
 	    // only castle if free and safe
 	    if (isFree and isSafe) 
 		movelist.push_back(Move(ownKingIndex, 1, false, false, false,
@@ -715,7 +633,8 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
     	    // are b1, c1 and d1 free?
     	    const bool isFree = (wlOccMask & ~b.occ) == wlOccMask;
     	    // are b1, c1, d1 and e1 safe?
-	    const bool isSafe = (wlDangerMask & ~kingDanger) == wlDangerMask;
+	    const bool isSafe
+		= not legal or ((wlDangerMask & ~kingDanger) == wlDangerMask);
 	    // only castle if free and safe
 	    if (isFree and isSafe) 
 		movelist.push_back(Move(ownKingIndex, 5, false, false, false,
@@ -729,7 +648,8 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
     	    // are f8 and g8 free?
     	    const bool isFree = (bsOccMask & ~b.occ) == bsOccMask;
     	    // are e8, f8 and g8 safe?
-	    const bool isSafe = (bsDangerMask & ~kingDanger) == bsDangerMask;
+	    const bool isSafe
+		= not legal or ((bsDangerMask & ~kingDanger) == bsDangerMask);
 	    // only castle if free and safe
 	    if (isFree and isSafe) 
 		movelist.push_back(Move(ownKingIndex, 57, false, false, false,
@@ -742,7 +662,8 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
     	    // are b8, c8 and d8 free?
     	    const bool isFree = (blOccMask & ~b.occ) == blOccMask;
     	    // are c8, d8 and e8 safe?
-	    const bool isSafe = (blDangerMask & ~kingDanger) == blDangerMask;
+	    const bool isSafe
+		= not legal or ((blDangerMask & ~kingDanger) == blDangerMask);
 	    // only castle if free and safe
 	    if (isFree and isSafe) 
 		movelist.push_back(Move(ownKingIndex, 61, false, false, false,
@@ -750,149 +671,602 @@ void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
     	}
     }
 
-} // end of generateLegalMoves
+} // end of generateSideMoves
 
 /******************************************************************************
- * Returns a bitmap of all pieces in an absolute pin from a rooklike enemy
- * slider. (moving side only)
- *
- * Overview:
- * 	- generate rooklike movement of the king on an empty board and check
- * 		if there are any enemy rooks or queens at all
- * 	- if so get their attack-square using the true board-occupancy
- * 	- AND the atk-square of king and potential pinner
- * 	- if this AND-mask coincides with a friendly piece its pinned D:
+ * Runtime dispatch on the side to move.
  */
-bitb detectLaterallyPinnedPieces(const GameState& gs) {
-    bitb pinned = 0x0ULL;
+CheckInfo computeCheckInfo(const GameState& gs) {
+    return (gs.whiteToMove ? computeCheckInfo<true>(gs)
+			   : computeCheckInfo<false>(gs));
+}
 
-    // reference to board
-    const Board& b = gs.board;
+CheckInfo computePinInfo(const GameState& gs) {
+    return (gs.whiteToMove
+	    ? computePinInfo<true>(gs, computeCheckers<true>(gs))
+	    : computePinInfo<false>(gs, computeCheckers<false>(gs)));
+}
 
-    const int ownKingIndex = BSF(gs.whiteToMove ? b.wKing : b.bKing);
-    bitb potentialPinner = (gs.whiteToMove ? (b.bRooks | b.bQueens)
-					   : (b.wRooks | b.wQueens));
-
-    // check if there can even be laterally pinned pieces
-    const bitb kingOnEmptyBoard = rookAttacks(0x0ULL, ownKingIndex);
-    potentialPinner &= kingOnEmptyBoard;
-    if (potentialPinner) {
-	// where are your frens?
-	const bitb kingOnTrueBoard = rookAttacks(b.occ, ownKingIndex);
-	// now iterate over the potential pinner and check if there is a
-	// friendly piece they pin
-	while (potentialPinner) {
-	    const int potentialPinnerIndex = BSF(potentialPinner);
-	    potentialPinner &= potentialPinner - 1;
-	    // get its attack squares
-	    const bitb atks = rookAttacks(b.occ, potentialPinnerIndex);
-	    // Now overlap the attack square from the kings location and the
-	    // enemies location and with all friendly pieces. Whatever is left
-	    // is indeed a pinned piece! D:
-	    pinned |= kingOnTrueBoard & atks;
-	}
+CheckInfo computePinInfo(const GameState& gs, const bitb checkers) {
+    return (gs.whiteToMove ? computePinInfo<true>(gs, checkers)
+			   : computePinInfo<false>(gs, checkers));
+}
+
+bitb computeCheckers(const GameState& gs) {
+    return (gs.whiteToMove ? computeCheckers<true>(gs)
+			   : computeCheckers<false>(gs));
+}
+
+template <GenType type>
+void generateMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist) {
+    if (gs.whiteToMove) generateSideMoves<true, type, true>(gs, ci, movelist);
+    else generateSideMoves<false, type, true>(gs, ci, movelist);
+} // end of generateMoves
+
+template <GenType type>
+void generatePseudoMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist) {
+    if (gs.whiteToMove) generateSideMoves<true, type, false>(gs, ci, movelist);
+    else generateSideMoves<false, type, false>(gs, ci, movelist);
+}
+
+template <GenType type>
+void generateMoves(const GameState& gs, MoveList& movelist, bool& inCheck) {
+    const CheckInfo ci = computeCheckInfo(gs);
+    inCheck = (ci.checkers != 0x0ULL);
+    generateMoves<type>(gs, ci, movelist);
+}
+
+template void generateMoves<GenType::all>(const GameState&, MoveList&, bool&);
+template void generateMoves<GenType::noisy>(const GameState&, MoveList&, bool&);
+template void generateMoves<GenType::quiets>(const GameState&, MoveList&, bool&);
+template void generateMoves<GenType::tactical>(const GameState&, MoveList&,
+									bool&);
+template void generateMoves<GenType::all>(const GameState&, const CheckInfo&,
+								MoveList&);
+template void generateMoves<GenType::noisy>(const GameState&, const CheckInfo&,
+								MoveList&);
+template void generateMoves<GenType::quiets>(const GameState&, const CheckInfo&,
+								MoveList&);
+template void generateMoves<GenType::tactical>(const GameState&,
+						const CheckInfo&, MoveList&);
+template void generatePseudoMoves<GenType::all>(const GameState&,
+						const CheckInfo&, MoveList&);
+template void generatePseudoMoves<GenType::noisy>(const GameState&,
+						const CheckInfo&, MoveList&);
+template void generatePseudoMoves<GenType::quiets>(const GameState&,
+						const CheckInfo&, MoveList&);
+template void generatePseudoMoves<GenType::tactical>(const GameState&,
+						const CheckInfo&, MoveList&);
+
+/******************************************************************************
+ * Function that generates all legal moves while the side to move is in check.
+ */
+void generateEvasions(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist) {
+    movelist.clear();
+    if (gs.whiteToMove) {
+	generateEvasionMoves<true, GenType::all>(gs, ci, movelist);
+    } else {
+	generateEvasionMoves<false, GenType::all>(gs, ci, movelist);
     }
+}
+
+/******************************************************************************
+ * Function that generates all legal moves in a given position, returns them
+ * on 'movelist'.
+ */
+void generateLegalMoves(const GameState& gs, MoveList& movelist,
+							    bool& inCheck) {
+    generateMoves<GenType::all>(gs, movelist, inCheck);
+}
 
-    return pinned;
+void generateLegalMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist) {
+    generateMoves<GenType::all>(gs, ci, movelist);
 }
 
 /******************************************************************************
- * (similar to 'detectLaterallyPinnedPieces')
- *
- * Returns a bitmap of all pieces in an absolute pin from a bishoplike enemy
- * slider. (moving side only)
+ * Counts the legal moves without creating them, see 'MoveCounter'.
+ */
+int countLegalMoves(const GameState& gs) {
+    const CheckInfo ci = computeCheckInfo(gs);
+    MoveCounter counter;
+    if (gs.whiteToMove)
+	generateSideMoves<true, GenType::all, true>(gs, ci, counter);
+    else generateSideMoves<false, GenType::all, true>(gs, ci, counter);
+    return counter.n;
+}
+
+bitb attackersTo(const Board& b, const int sq, const bitb occ) {
+    const bitb sqMask = (1ULL << sq);
+    const bitb queens = b.wQueens() | b.bQueens();
+    return (b.wPawns() & pawnAttacks<false>(sqMask))
+	 | (b.bPawns() & pawnAttacks<true>(sqMask))
+	 | ((b.wKnights() | b.bKnights()) & knightAttacks[sq])
+	 | ((b.wKing() | b.bKing()) & kingAttacks[sq])
+	 | ((b.wBishops() | b.bBishops() | queens) & bishopAttacks(occ, sq))
+	 | ((b.wRooks() | b.bRooks() | queens) & rookAttacks(occ, sq));
+}
+
+/******************************************************************************
+ * Lazy legality test of a pseudo-legal move.
  *
- * Overview:
- * 	- generate bishoplike movement of the king on an empty board and check
- * 		if there are any enemy bishops or queens at all
- * 	- if so get their attack-square using the true board-occupancy
- * 	- AND the atk-square of king and potential pinner
- * 	- if this AND-mask coincides with a friendly piece its pinned D:
+ * Without check only three kinds of moves can leave the own king attacked:
+ * king moves (the target is tested with the king removed from the board so
+ * it can not hide behind itself), en passant (two pawns leave the board at
+ * once, tested against all sliders) and moves of pinned pieces, which have
+ * to stay on their pin line. Castling also needs the squares the king passes
+ * to be safe. In check every move is tested on the occupancy after the move.
  */
-bitb detectDiagonallyPinnedPieces(const GameState& gs) {
-    bitb pinned = 0x0ULL;
+template <bool wtm>
+static bool isLegal(const GameState& gs, const CheckInfo& ci, const Move& m) {
+    const Board& b = gs.board;
+    const int from = m.from();
+    const int to = m.to();
+    const bitb fromMask = (1ULL << from);
+    const bitb toMask = (1ULL << to);
+    const bitb ownKing = (wtm ? b.wKing() : b.bKing());
+    const int ownKingIndex = BSF(ownKing);
 
-    // reference to board
+    if (m.castle()) {
+	if (ci.checkers) return false;
+	const int step = (to > from ? 1 : -1);
+	for (int sq = from+step; sq != to+step; sq += step) {
+	    if (enemyAttackers<wtm>(b, sq, b.occ)) return false;
+	}
+	return true;
+    }
+
+    // the piece on 'to' can not attack its own square, no need to remove it
+    if (fromMask & ownKing)
+	return not enemyAttackers<wtm>(b, to, b.occ ^ ownKing);
+
+    if (m.ep() or ci.checkers) {
+	constexpr int up = (wtm ? 8 : -8);
+	const bitb capturedMask = (m.ep() ? shift<-up>(toMask)
+				 : (m.capture() ? toMask : 0x0ULL));
+	const bitb occAfter = (b.occ ^ fromMask ^ capturedMask) | toMask;
+	return not (enemyAttackers<wtm>(b, ownKingIndex, occAfter)
+							    & ~capturedMask);
+    }
+
+    if (fromMask & (ci.latPinned | ci.diaPinned))
+	return line[ownKingIndex][from] & toMask;
+
+    return true;
+}
+
+bool isLegal(const GameState& gs, const CheckInfo& ci, const Move& m) {
+    return (gs.whiteToMove ? isLegal<true>(gs, ci, m)
+			   : isLegal<false>(gs, ci, m));
+}
+
+/******************************************************************************
+ * Verifies that 'm' could have been generated in this position (ignoring
+ * pins and checks). The move is rebuilt from the board and compared to 'm',
+ * so moves with flags that do not fit the board are rejected as well.
+ */
+template <bool wtm>
+static bool isPseudoLegal(const GameState& gs, const Move& m) {
     const Board& b = gs.board;
+    const int from = m.from();
+    const int to = m.to();
+    if (from == to) return false; // also catches 'no move'
+
+    const bitb own = (wtm ? b.white() : b.black());
+    const bitb enemies = (wtm ? b.black() : b.white());
+    const bitb fromMask = (1ULL << from);
+    const bitb toMask = (1ULL << to);
+    if (not (own & fromMask) or (own & toMask)) return false;
+    const bool capture = (enemies & toMask);
+
+    constexpr int up = (wtm ? 8 : -8);
+    constexpr bitb promoRanks = 0xff000000000000ffULL;
+    constexpr bitb doublePushRank = (wtm ? 0xff00ULL : 0xff000000000000ULL);
+
+    if (fromMask & (wtm ? b.wPawns() : b.bPawns())) {
+	if (m.ep()) {
+	    return gs.epTarget == to and (pawnAttacks<wtm>(fromMask) & toMask)
+		and m == Move(from, to, true, false, true, false, false, ' ');
+	}
+	if (m.doublePawnPush()) {
+	    return to == from + 2*up and (fromMask & doublePushRank)
+		and not (b.occ & ((1ULL << (from+up)) | toMask));
+	}
+	if (capture) {
+	    if (not (pawnAttacks<wtm>(fromMask) & toMask)) return false;
+	} else if (to != from + up or (b.occ & toMask)) {
+	    return false;
+	}
+	const bool promo = (toMask & promoRanks);
+	return m == Move(from, to, capture, false, false, false, promo,
+					    (promo ? m.promoPiece() : ' '));
+    }
 
-    const int ownKingIndex = BSF(gs.whiteToMove ? b.wKing : b.bKing);
-    bitb potentialPinner = (gs.whiteToMove ? (b.bBishops | b.bQueens)
-					   : (b.wBishops | b.wQueens));
-
-    // check if there can even be diagonally pinned pieces
-    const bitb kingOnEmptyBoard = bishopAttacks(0x0ULL, ownKingIndex);
-    potentialPinner &= kingOnEmptyBoard;
-    if (potentialPinner) {
-	// where are your frens?
-	const bitb kingOnTrueBoard = bishopAttacks(b.occ, ownKingIndex);
-	// now iterate over the potential pinner and check if there is a
-	// friendly piece they pin
-	while (potentialPinner) {
-	    const int potentialPinnerIndex = BSF(potentialPinner);
-	    potentialPinner &= potentialPinner - 1;
-	    // get its attack squares
-	    const bitb atks = bishopAttacks(b.occ, potentialPinnerIndex);
-	    // Now overlap the attack square from the kings location and the
-	    // enemies location and with all friendly pieces. Whatever is left
-	    // is indeed a pinned piece! D:
-	    pinned |= kingOnTrueBoard & atks;
+    const bitb ownKing = (wtm ? b.wKing() : b.bKing());
+    if (m.castle()) {
+	if (not (fromMask & ownKing)) return false;
+	// king target, rights and the squares that have to be empty
+	if constexpr (wtm) {
+	    if (to == 1) return gs.whiteShort and not (b.occ & 0x6ULL);
+	    if (to == 5) return gs.whiteLong and not (b.occ & 0x70ULL);
+	} else {
+	    if (to == 57)
+		return gs.blackShort and not (b.occ & 0x600000000000000ULL);
+	    if (to == 61)
+		return gs.blackLong and not (b.occ & 0x7000000000000000ULL);
 	}
+	return false;
     }
 
-    return pinned;
+    if (m != Move(from, to, capture, false, false, false, false, ' '))
+	return false;
+
+    bitb attacks;
+    if (fromMask & ownKing) attacks = kingAttacks[from];
+    else if (fromMask & (wtm ? b.wKnights() : b.bKnights()))
+	attacks = knightAttacks[from];
+    else if (fromMask & (wtm ? b.wBishops() : b.bBishops()))
+	attacks = bishopAttacks(b.occ, from);
+    else if (fromMask & (wtm ? b.wRooks() : b.bRooks()))
+	attacks = rookAttacks(b.occ, from);
+    else attacks = bishopAttacks(b.occ, from) | rookAttacks(b.occ, from);
+    return attacks & toMask;
+}
+
+bool isPseudoLegal(const GameState& gs, const Move& m) {
+    return (gs.whiteToMove ? isPseudoLegal<true>(gs, m)
+			   : isPseudoLegal<false>(gs, m));
 }
 
 /******************************************************************************
- * Function that calculates all square attacked by the opponent.
+ * Checking squares and discovered check candidates of the side 'wtm'. The
+ * discoverers are found like pinned pieces, only from the enemy king and with
+ * own sliders behind the blocker.
  */
-bitb generateKingDanger(const GameState& gs) {
-    // reference to board
+template <bool wtm>
+static CheckSquares computeCheckSquares(const GameState& gs) {
+    const Board& b = gs.board;
+    const int us = (wtm ? 0 : 1);
+    const bitb own = b.colors[us];
+    const int enemyKingIndex = BSF(b.get(1 - us, pieceType::king));
+
+    CheckSquares cs;
+    cs.squares[pieceIndex(pieceType::pawn)]
+	= pawnAttacks<!wtm>(1ULL << enemyKingIndex);
+    cs.squares[pieceIndex(pieceType::knight)] = knightAttacks[enemyKingIndex];
+    cs.squares[pieceIndex(pieceType::bishop)]
+	= bishopAttacks(b.occ, enemyKingIndex);
+    cs.squares[pieceIndex(pieceType::rook)] = rookAttacks(b.occ, enemyKingIndex);
+    cs.squares[pieceIndex(pieceType::queen)]
+	= cs.squares[pieceIndex(pieceType::bishop)]
+	| cs.squares[pieceIndex(pieceType::rook)];
+    cs.squares[pieceIndex(pieceType::king)] = 0x0ULL;
+
+    const bitb ownQueens = b.get(us, pieceType::queen);
+    bitb sliders
+	= ((b.get(us, pieceType::rook) | ownQueens)
+				& rookAttacks(0x0ULL, enemyKingIndex))
+	| ((b.get(us, pieceType::bishop) | ownQueens)
+				& bishopAttacks(0x0ULL, enemyKingIndex));
+    cs.discoverers = 0x0ULL;
+    while (sliders) {
+	const int sliderIndex = BSF(sliders);
+	sliders &= sliders - 1;
+	const bitb blockers = between[enemyKingIndex][sliderIndex] & b.occ;
+	if (not (blockers & (blockers - 1))) cs.discoverers |= blockers & own;
+    }
+
+    return cs;
+}
+
+CheckSquares computeCheckSquares(const GameState& gs) {
+    return (gs.whiteToMove ? computeCheckSquares<true>(gs)
+			   : computeCheckSquares<false>(gs));
+}
+
+/******************************************************************************
+ * Tests if the legal move 'm' gives check.
+ *
+ * Direct checks land on a checking square of the moving piece, discovered
+ * checks move a discoverer off its line to the enemy king. Promotions,
+ * en passant (two pawns leave their squares) and castling (the rook gives
+ * check) are tested on the occupancy after the move.
+ */
+template <bool wtm>
+static bool givesCheck(const GameState& gs, const CheckSquares& cs,
+							    const Move& m) {
     const Board& b = gs.board;
+    const int us = (wtm ? 0 : 1);
+    const int from = m.from();
+    const int to = m.to();
+    const bitb fromMask = (1ULL << from);
+    const bitb toMask = (1ULL << to);
+    const pieceType piece = b.squares[from];
+    const bitb enemyKing = b.get(1 - us, pieceType::king);
+    const int enemyKingIndex = BSF(enemyKing);
 
-    // occupation without own king
-    const bitb modocc = b.occ ^ (gs.whiteToMove ? b.wKing : b.bKing);
+    // direct check
+    if (not m.promo() and (cs.squares[pieceIndex(piece)] & toMask))
+	return true;
 
-    // enemy pieces by type
-    bitb enemyPawns = (gs.whiteToMove ? b.bPawns : b.wPawns);
-    bitb enemyKnights = (gs.whiteToMove ? b.bKnights : b.wKnights);
-    bitb enemyBishops = (gs.whiteToMove ? b.bBishops : b.wBishops);
-    bitb enemyRooks = (gs.whiteToMove ? b.bRooks : b.wRooks);
-    bitb enemyQueens = (gs.whiteToMove ? b.bQueens : b.wQueens);
-    bitb enemyKing = (gs.whiteToMove ? b.bKing : b.wKing);
-    bitb enemyRooklikeSlider = enemyRooks | enemyQueens;
-    bitb enemyBishoplikeSlider = enemyBishops | enemyQueens;
+    // discovered check
+    if ((cs.discoverers & fromMask)
+	    and not (line[enemyKingIndex][from] & toMask))
+	return true;
 
-    // generate king danger
-    bitb kingDanger = kingAttacks[BSF(enemyKing)];
-    while (enemyKnights) {
-	kingDanger |= knightAttacks[BSF(enemyKnights)];
-	enemyKnights &= enemyKnights - 1;
+    if (m.promo()) {
+	const bitb occ = b.occ ^ fromMask;
+	switch (m.promoPiece()) {
+	    case 'n': return knightAttacks[to] & enemyKing;
+	    case 'b': return bishopAttacks(occ, to) & enemyKing;
+	    case 'r': return rookAttacks(occ, to) & enemyKing;
+	    default: return (bishopAttacks(occ, to) | rookAttacks(occ, to))
+							    & enemyKing;
+	}
     }
-    while (enemyRooklikeSlider) {
-	kingDanger |= rookAttacks(modocc, BSF(enemyRooklikeSlider));
-	enemyRooklikeSlider &= enemyRooklikeSlider - 1;
+
+    if (m.ep()) {
+	constexpr int up = (wtm ? 8 : -8);
+	const bitb occ = (b.occ ^ fromMask ^ shift<-up>(toMask)) | toMask;
+	const bitb ownQueens = b.get(us, pieceType::queen);
+	return ((b.get(us, pieceType::bishop) | ownQueens)
+				& bishopAttacks(occ, enemyKingIndex))
+	    or ((b.get(us, pieceType::rook) | ownQueens)
+				& rookAttacks(occ, enemyKingIndex));
     }
-    while (enemyBishoplikeSlider) {
-	kingDanger |= bishopAttacks(modocc, BSF(enemyBishoplikeSlider));
-	enemyBishoplikeSlider &= enemyBishoplikeSlider - 1;
+
+    if (m.castle()) {
+	// the rook ends up next to the king, on the square the king passed
+	const int rookTo = (from + to) / 2;
+	const int rookFrom = (to < from ? (wtm ? 0 : 56) : (wtm ? 7 : 63));
+	const bitb occ = b.occ ^ fromMask ^ toMask
+		       ^ (1ULL << rookFrom) ^ (1ULL << rookTo);
+	return rookAttacks(occ, rookTo) & enemyKing;
     }
-    kingDanger |= pawnAttacks(!gs.whiteToMove, enemyPawns);
 
-    return kingDanger;
+    return false;
 }
 
-bitb pawnAttacks(const bool whiteToMove, const bitb pawns) {
+bool givesCheck(const GameState& gs, const CheckSquares& cs, const Move& m) {
+    return (gs.whiteToMove ? givesCheck<true>(gs, cs, m)
+			   : givesCheck<false>(gs, cs, m));
+}
+
+bool givesCheck(const GameState& gs, const Move& m) {
+    return givesCheck(gs, computeCheckSquares(gs), m);
+}
+
+/******************************************************************************
+ * Set-wise slider attacks with Kogge-Stone occluded fills
+ *
+ * All sliders of one kind are flooded at once along a direction 'd' through
+ * the empty squares in three doubling steps (1, 2 and 4 squares), the fill
+ * shifted by one more step are then their attacks. Steps to the west (and the
+ * a-file) wrap around onto the h-file and vice versa, the wrap masks keep
+ * them off those files.
+ */
+template <int d>
+static inline bitb occludedFillAttacks(bitb gen, bitb empty) {
     constexpr bitb aFile = 0x8080808080808080ULL;
     constexpr bitb hFile = 0x101010101010101ULL;
+    constexpr int west = ((d % 8) + 8) % 8; // 1 for west, 7 for east steps
+    constexpr bitb wrap = (west == 1 ? ~hFile : west == 7 ? ~aFile : ~0x0ULL);
+    empty &= wrap;
+    gen |= empty & shift<d>(gen);
+    empty &= shift<d>(empty);
+    gen |= empty & shift<2*d>(gen);
+    empty &= shift<2*d>(empty);
+    gen |= empty & shift<4*d>(gen);
+    return shift<d>(gen) & wrap;
+}
 
-    if (whiteToMove) {
-	return ((pawns & ~hFile) << 7) | ((pawns & ~aFile) << 9);
-    } else {
-	return ((pawns & ~hFile) >> 9) | ((pawns & ~aFile) >> 7);
+static bitb scalarSliderAttacks(const bitb rooklike, const bitb bishoplike,
+							    const bitb occ) {
+    const bitb empty = ~occ;
+    return occludedFillAttacks<8>(rooklike, empty)
+	 | occludedFillAttacks<-8>(rooklike, empty)
+	 | occludedFillAttacks<1>(rooklike, empty)
+	 | occludedFillAttacks<-1>(rooklike, empty)
+	 | occludedFillAttacks<9>(bishoplike, empty)
+	 | occludedFillAttacks<-9>(bishoplike, empty)
+	 | occludedFillAttacks<7>(bishoplike, empty)
+	 | occludedFillAttacks<-7>(bishoplike, empty);
+}
+
+/******************************************************************************
+ * AVX2 version of the fills above. The four lanes are the directions north,
+ * west, northwest and northeast (rooklike, rooklike, bishoplike, bishoplike),
+ * all upwards shifts. The opposite directions are the same with downwards
+ * shifts. Compiled for AVX2 regardless of the build flags, only called if the
+ * CPU supports it.
+ */
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static bitb avx2SliderAttacks(const bitb rooklike, const bitb bishoplike,
+							    const bitb occ) {
+    constexpr long long notA = ~0x8080808080808080ULL;
+    constexpr long long notH = ~0x101010101010101ULL;
+    const __m256i s1 = _mm256_setr_epi64x(8, 1, 9, 7);
+    const __m256i s2 = _mm256_setr_epi64x(16, 2, 18, 14);
+    const __m256i s4 = _mm256_setr_epi64x(32, 4, 36, 28);
+    const __m256i upWrap = _mm256_setr_epi64x(~0x0LL, notH, notH, notA);
+    const __m256i downWrap = _mm256_setr_epi64x(~0x0LL, notA, notA, notH);
+    const __m256i sliders = _mm256_setr_epi64x(rooklike, rooklike,
+					       bishoplike, bishoplike);
+    const __m256i empty = _mm256_set1_epi64x(~occ);
+
+    // upwards
+    __m256i gen = sliders;
+    __m256i pro = _mm256_and_si256(empty, upWrap);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_sllv_epi64(gen, s1)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, s1));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_sllv_epi64(gen, s2)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, s2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_sllv_epi64(gen, s4)));
+    const __m256i up = _mm256_and_si256(_mm256_sllv_epi64(gen, s1), upWrap);
+
+    // downwards
+    gen = sliders;
+    pro = _mm256_and_si256(empty, downWrap);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_srlv_epi64(gen, s1)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, s1));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_srlv_epi64(gen, s2)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, s2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro,
+					_mm256_srlv_epi64(gen, s4)));
+    const __m256i down = _mm256_and_si256(_mm256_srlv_epi64(gen, s1),
+								downWrap);
+
+    // OR of all eight directions
+    const __m256i all = _mm256_or_si256(up, down);
+    const __m128i half = _mm_or_si128(_mm256_castsi256_si128(all),
+				      _mm256_extracti128_si256(all, 1));
+    return _mm_cvtsi128_si64(half) | _mm_extract_epi64(half, 1);
+}
+#endif
+
+bitb sliderAttacks(const bitb rooklike, const bitb bishoplike,
+							    const bitb occ) {
+#if defined(__x86_64__)
+    if (fillBackend == FillBackend::avx2)
+	return avx2SliderAttacks(rooklike, bishoplike, occ);
+#endif
+    if (fillBackend == FillBackend::scalar)
+	return scalarSliderAttacks(rooklike, bishoplike, occ);
+    // lookups per slider
+    bitb atks = 0x0ULL;
+    bitb sliders = rooklike;
+    while (sliders) {
+	atks |= rookAttacks(occ, BSF(sliders));
+	sliders &= sliders - 1;
     }
+    sliders = bishoplike;
+    while (sliders) {
+	atks |= bishopAttacks(occ, BSF(sliders));
+	sliders &= sliders - 1;
+    }
+    return atks;
+}
+
+/******************************************************************************
+ * All squares attacked by the pieces of the side 'white', sliders see through
+ * everything that is not in 'occ'.
+ */
+template <bool white>
+static bitb allAttacks(const Board& b, const bitb occ) {
+    constexpr bitb aFile = 0x8080808080808080ULL;
+    constexpr bitb hFile = 0x101010101010101ULL;
+    constexpr bitb abFiles = 0xc0c0c0c0c0c0c0c0ULL;
+    constexpr bitb ghFiles = 0x303030303030303ULL;
+    const bitb knights = (white ? b.wKnights() : b.bKnights());
+    const bitb queens = (white ? b.wQueens() : b.bQueens());
+
+    // set-wise knight jumps, west jumps must not start on the a-file (a-
+    // and b-file for two files to the west) and vice versa
+    const bitb west1 = knights & ~aFile;
+    const bitb west2 = knights & ~abFiles;
+    const bitb east1 = knights & ~hFile;
+    const bitb east2 = knights & ~ghFiles;
+    const bitb knightAtks = shift<17>(west1) | shift<-15>(west1)
+			  | shift<10>(west2) | shift<-6>(west2)
+			  | shift<15>(east1) | shift<-17>(east1)
+			  | shift<6>(east2) | shift<-10>(east2);
+
+    return kingAttacks[BSF(white ? b.wKing() : b.bKing())]
+	 | knightAtks
+	 | pawnAttacks<white>(white ? b.wPawns() : b.bPawns())
+	 | sliderAttacks((white ? b.wRooks() : b.bRooks()) | queens,
+			 (white ? b.wBishops() : b.bBishops()) | queens, occ);
+}
+
+bitb allAttacks(const Board& b, const bool white, const bitb occ) {
+    return (white ? allAttacks<true>(b, occ) : allAttacks<false>(b, occ));
+}
+
+/******************************************************************************
+ * Function that calculates all square attacked by the opponent, the own king
+ * is removed so it can not hide behind itself.
+ */
+template <bool wtm>
+static bitb generateKingDanger(const GameState& gs) {
+    const Board& b = gs.board;
+    return allAttacks<!wtm>(b, b.occ ^ (wtm ? b.wKing() : b.bKing()));
+}
+
+bitb generateKingDanger(const GameState& gs) {
+    return (gs.whiteToMove ? generateKingDanger<true>(gs)
+			   : generateKingDanger<false>(gs));
+}
+
+bitb pawnAttacks(const bool whiteToMove, const bitb pawns) {
+    return (whiteToMove ? pawnAttacks<true>(pawns) : pawnAttacks<false>(pawns));
 }
 
 bitb rookAttacks(const bitb occ, const int index) {
+#if defined(__x86_64__)
+    if (sliderBackend == SliderBackend::pext)
+	return pextRookAttacks(occ, index);
+#endif
+    if (sliderBackend == SliderBackend::magic)
+	return magicRookAttacks(occ, index);
+    return rayRookAttacks(occ, index);
+}
+
+bitb bishopAttacks(const bitb occ, const int index) {
+#if defined(__x86_64__)
+    if (sliderBackend == SliderBackend::pext)
+	return pextBishopAttacks(occ, index);
+#endif
+    if (sliderBackend == SliderBackend::magic)
+	return magicBishopAttacks(occ, index);
+    return rayBishopAttacks(occ, index);
+}
+
+/******************************************************************************
+ * Returns the fastest slider backend available on this CPU.
+ */
+SliderBackend detectSliderBackend() {
+    if (fastPext()) return SliderBackend::pext;
+    return SliderBackend::magic;
+}
+
+/******************************************************************************
+ * Returns the fastest set-wise attack backend available on this CPU.
+ */
+FillBackend detectFillBackend() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) return FillBackend::avx2;
+#endif
+    return FillBackend::scalar;
+}
+
+std::string_view toString(FillBackend backend) {
+    switch (backend) {
+	case FillBackend::lookup: return "lookup";
+	case FillBackend::scalar: return "kogge-stone";
+	case FillBackend::avx2: return "avx2";
+    }
+    return "";
+}
+
+std::string_view toString(SliderBackend backend) {
+    switch (backend) {
+	case SliderBackend::pext: return "pext";
+	case SliderBackend::magic: return "magic";
+	case SliderBackend::rays: return "rays";
+    }
+    return "";
+}
+
+bitb rayRookAttacks(const bitb occ, const int index) {
     bitb atks = 0ULL;
     bitb atkray, blocker;
     int sq; 
@@ -936,7 +1310,7 @@ bitb rookAttacks(const bitb occ, const int index) {
     return atks;
 }
 
-bitb bishopAttacks(const bitb occ, const int index) {
+bitb rayBishopAttacks(const bitb occ, const int index) {
     bitb atks = 0ULL;
     bitb atkray, blocker;
     int sq; 
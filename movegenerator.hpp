@@ -1,36 +1,182 @@
 #pragma once
 
-#include <vector>
+#include <string_view>
 
 #include "params.hpp"
 #include "board.hpp"
 #include "move.hpp"
 
+/******************************************************************************
+ * Check and pin information of a position (for the side to move)
+ *
+ * Computed once per node with 'computeCheckInfo' and then shared by the move
+ * generator and the search, so none of it has to be recomputed. A pinned
+ * piece may only move along the line through its king and itself (see
+ * 'line' in raylookup.hpp).
+ */
+struct CheckInfo {
+    bitb checkers;   // enemy pieces giving check
+    bitb kingDanger; // squares attacked by the enemy (own king removed)
+    bitb latPinned;  // own pieces pinned by a rooklike slider
+    bitb diaPinned;  // own pieces pinned by a bishoplike slider
+};
+
+CheckInfo computeCheckInfo(const GameState& gs);
+
+/******************************************************************************
+ * Same as above, but the king danger is only computed if the side to move is
+ * in check. Sufficient for the pseudo-legal generator and 'isLegal'. The
+ * checkers can be given if they are already known.
+ */
+CheckInfo computePinInfo(const GameState& gs);
+CheckInfo computePinInfo(const GameState& gs, const bitb checkers);
+
+/******************************************************************************
+ * Returns the enemy pieces giving check to the king of the side to move, all
+ * a node needs before it knows it will search any move.
+ */
+bitb computeCheckers(const GameState& gs);
+
 /******************************************************************************
  * Function that generates all legal moves in a given position. Returns the
  * number of legal moves and gives the moves themself on 'movelist'.
  */
-void generateLegalMoves(const GameState& gs, std::vector<Move>& movelist,
+void generateLegalMoves(const GameState& gs, MoveList& movelist,
 							bool& inCheck);
+void generateLegalMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist);
 
 /******************************************************************************
- * Function that calculates all square attacked by the opponent.
+ * Returns the number of legal moves in a given position without generating
+ * the moves themself (e.g. for the leaves of perft).
  */
-bitb generateKingDanger(const GameState& gs);
+int countLegalMoves(const GameState& gs);
+
+/******************************************************************************
+ * Kinds of legal moves that can be generated separately
+ *
+ * all      - all legal moves
+ * noisy    - captures (including en passant) and promotions
+ * quiets   - all other moves (including castling)
+ * tactical - captures and queen promotions, used by the quiescence search
+ */
+enum class GenType { all, noisy, quiets, tactical };
+
+template <GenType type>
+void generateMoves(const GameState& gs, MoveList& movelist, bool& inCheck);
+
+/******************************************************************************
+ * Same as above, with the check info of the position already computed.
+ */
+template <GenType type>
+void generateMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist);
+
+/******************************************************************************
+ * Pseudo-legal version of 'generateMoves'. Pins, the king danger and the
+ * en passant discovered checks are ignored, every move has to pass 'isLegal'
+ * before it is played. If the side to move is in check the legal evasions
+ * are generated instead (of the given kind).
+ */
+template <GenType type>
+void generatePseudoMoves(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist);
+
+/******************************************************************************
+ * Returns true if the pseudo-legal move 'm' does not leave the own king in
+ * check. 'ci' only needs the pin information (see 'computePinInfo').
+ */
+bool isLegal(const GameState& gs, const CheckInfo& ci, const Move& m);
+
+/******************************************************************************
+ * Returns true if 'm' is a pseudo-legal move in this position, i.e. it could
+ * have been generated by 'generatePseudoMoves'. Used to verify hash and killer
+ * moves without generating any moves.
+ */
+bool isPseudoLegal(const GameState& gs, const Move& m);
+
+/******************************************************************************
+ * Checking squares of the side to move
+ *
+ * For every piece type the squares from which it would give check to the
+ * enemy king and the own pieces that give a discovered check if they leave
+ * the line between an own slider and the enemy king. Computed once per node
+ * with 'computeCheckSquares' and then shared by all 'givesCheck' tests.
+ */
+struct CheckSquares {
+    bitb squares[6];  // by piece type (see 'pieceIndex')
+    bitb discoverers; // discovered check candidates
+};
+
+CheckSquares computeCheckSquares(const GameState& gs);
+
+/******************************************************************************
+ * Returns true if the legal move 'm' gives check, without making the move.
+ * Covers direct, discovered, promotion, en passant and castling checks.
+ */
+bool givesCheck(const GameState& gs, const CheckSquares& cs, const Move& m);
+bool givesCheck(const GameState& gs, const Move& m);
 
 /******************************************************************************
- * Returns a bitmap of all pieces in an absolute pin from a rooklike enemy
- * slider. (moving side only)
+ * Function that generates all legal moves while the side to move is in check
+ * (king moves, captures of the checker and blocks). Must only be called if
+ * the side to move actually is in check.
  */
-bitb detectLaterallyPinnedPieces(const GameState& gs);
+void generateEvasions(const GameState& gs, const CheckInfo& ci,
+						    MoveList& movelist);
 
 /******************************************************************************
- * Returns a bitmap of all pieces in an absolute pin from a bishoplike enemy
- * slider. (moving side only)
+ * Returns all pieces of both colors that attack the square 'sq' on a board
+ * with the occupancy 'occ'. The occupancy is given by the caller, so sliders
+ * x-raying through removed pieces (e.g. for SEE) only cost another call.
  */
-bitb detectDiagonallyPinnedPieces(const GameState& gs);
+bitb attackersTo(const Board& b, const int sq, const bitb occ);
+
+/******************************************************************************
+ * Function that calculates all square attacked by the opponent.
+ */
+bitb generateKingDanger(const GameState& gs);
 
 bitb pawnAttacks(const bool whiteToMove, const bitb pawns);
+
+/******************************************************************************
+ * Attacks of sliding pieces. Looked up from the PEXT tables on CPUs with fast
+ * BMI2 and from the magic bitboards otherwise (chosen at startup). The
+ * ray-scan implementation can be selected as well (e.g. to compare perft
+ * results of all of them).
+ */
+enum class SliderBackend { rays, magic, pext };
+extern SliderBackend sliderBackend;
+
 bitb rookAttacks(const bitb occ, const int index);
 bitb bishopAttacks(const bitb occ, const int index);
+bitb rayRookAttacks(const bitb occ, const int index);
+bitb rayBishopAttacks(const bitb occ, const int index);
+
+/******************************************************************************
+ * Returns the fastest slider backend available on this CPU and its name.
+ */
+SliderBackend detectSliderBackend();
+std::string_view toString(SliderBackend backend);
+
+/******************************************************************************
+ * Set-wise attacks of whole piece sets, e.g. for the king danger. The sliders
+ * are either flooded all at once with Kogge-Stone fills (scalar, or the
+ * directions in parallel AVX2 lanes) or looked up one by one with the slider
+ * backend above.
+ */
+enum class FillBackend { lookup, scalar, avx2 };
+extern FillBackend fillBackend;
+
+// attacks of all rooklike and bishoplike sliders given
+bitb sliderAttacks(const bitb rooklike, const bitb bishoplike,
+							const bitb occ);
+// all squares attacked by the side 'white' on a board with occupancy 'occ'
+bitb allAttacks(const Board& b, const bool white, const bitb occ);
+
+/******************************************************************************
+ * Returns the fastest fill backend available on this CPU and its name.
+ */
+FillBackend detectFillBackend();
+std::string_view toString(FillBackend backend);
 
@@ -0,0 +1,129 @@
+#include "movepicker.hpp"
+
+#include "params.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "movegenerator.hpp"
+
+void scoreMoves(const GameState& gs, MoveList& ml, const Move& hashmove);
+void sortMove(MoveList& ml, const int n);
+
+MovePicker::MovePicker(const GameState& gs, const CheckInfo& ci,
+			const Move& hashmove, const Move* killers)
+    : gs(gs), ci(ci), hashmove(hashmove) {
+    if (killers != nullptr) {
+	this->killers[0] = killers[0];
+	this->killers[1] = killers[1];
+    }
+    stage = (azalea::stagedMovePicker ? Stage::hashMove : Stage::genAll);
+}
+
+/******************************************************************************
+ * Returns the next move of the node on 'm', false if there are no moves left.
+ */
+bool MovePicker::next(Move& m) {
+    switch (stage) {
+	case Stage::hashMove:
+	    stage = (ci.checkers ? Stage::genEvasions : Stage::genNoisy);
+	    if (playable(hashmove)) {
+		hashmovePicked = true;
+		m = hashmove;
+		return true;
+	    }
+	    return next(m);
+
+	case Stage::genNoisy:
+	    generatePseudoMoves<GenType::noisy>(gs, ci, ml);
+	    scoreMoves(gs, ml, hashmove);
+	    cur = 0;
+	    pseudoLegal = true;
+	    stage = Stage::noisy;
+	    [[fallthrough]];
+
+	case Stage::noisy:
+	    if (pickFromList(m)) return true;
+	    stage = Stage::killers;
+	    [[fallthrough]];
+
+	case Stage::killers:
+	    while (killerIndex < 2) {
+		const Move& k = killers[killerIndex++];
+		if (k.capture() or k.promo()) continue;
+		if (hashmovePicked and k == hashmove) continue;
+		if (killerIndex == 2 and k == killers[0]) continue;
+		if (playable(k)) {
+		    m = k;
+		    return true;
+		}
+	    }
+	    stage = Stage::genQuiets;
+	    [[fallthrough]];
+
+	case Stage::genQuiets:
+	    generatePseudoMoves<GenType::quiets>(gs, ci, ml);
+	    // in the order of generation
+	    for (int i=0; i<ml.size(); i++) ml.scores[i] = 0;
+	    cur = 0;
+	    stage = Stage::quiets;
+	    [[fallthrough]];
+
+	case Stage::quiets:
+	    while (pickFromList(m)) {
+		// legal killers were already handed out
+		if (m == killers[0] or m == killers[1]) continue;
+		return true;
+	    }
+	    stage = Stage::done;
+	    return false;
+
+	case Stage::genEvasions:
+	    generateEvasions(gs, ci, ml);
+	    scoreMoves(gs, ml, hashmove);
+	    cur = 0;
+	    stage = Stage::all;
+	    return next(m);
+
+	case Stage::genAll: {
+	    // 'ci' lacks the king danger, the legal moves need the full info
+	    bool dummy;
+	    generateLegalMoves(gs, ml, dummy);
+	    scoreMoves(gs, ml, hashmove);
+	    cur = 0;
+	    stage = Stage::all;
+	}
+	    [[fallthrough]];
+
+	case Stage::all:
+	    if (pickFromList(m)) return true;
+	    stage = Stage::done;
+	    return false;
+
+	case Stage::done:
+	    return false;
+    }
+    return false;
+}
+
+/******************************************************************************
+ * Picks the best scored move that is left in the current list, skips the hash
+ * move if it was already handed out and pseudo-legal moves that turn out to
+ * be illegal.
+ */
+bool MovePicker::pickFromList(Move& m) {
+    while (cur < ml.size()) {
+	sortMove(ml, cur);
+	m = ml[cur++];
+	if (hashmovePicked and m == hashmove) continue;
+	if (pseudoLegal and not isLegal(gs, ci, m)) continue;
+	return true;
+    }
+    return false;
+}
+
+/******************************************************************************
+ * Checks if a move that was not generated here (hash move or killer) can be
+ * played in this position, without generating any moves.
+ */
+bool MovePicker::playable(const Move& m) const {
+    return isPseudoLegal(gs, m) and isLegal(gs, ci, m);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "params.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "movegenerator.hpp"
+
+/******************************************************************************
+ * Staged move picker
+ *
+ * Hands out the moves of a node one at a time and generates them lazily:
+ * 	1. hash move (without any move generation)
+ * 	2. noisy moves (captures and promotions) sorted by MVV-LVA
+ * 	3. killer moves (without any move generation)
+ * 	4. remaining quiet moves
+ * Most cut nodes cut off on the hash move or on the first capture, their
+ * quiet moves are then never generated.
+ *
+ * Noisy and quiet moves are generated pseudo-legal and only tested with
+ * 'isLegal' once they are picked. Hash and killer moves are verified with
+ * 'isPseudoLegal' first. 'ci' only needs the pin info of the position.
+ *
+ * If the side to move is in check, all evasions are generated at once after
+ * the hash move and picked by their score.
+ *
+ * If 'azalea::stagedMovePicker' is false all legal moves are generated
+ * upfront and picked by their score (hash move, MVV-LVA, rest), which allows
+ * to compare both schemes.
+ */
+class MovePicker {
+public:
+    MovePicker(const GameState& gs, const CheckInfo& ci, const Move& hashmove,
+						    const Move* killers);
+
+    // returns false once all moves have been picked
+    bool next(Move& m);
+
+private:
+    enum class Stage {
+	hashMove, genNoisy, noisy, killers, genQuiets, quiets, genEvasions,
+	genAll, all, done
+    };
+
+    bool playable(const Move& m) const;
+    bool pickFromList(Move& m);
+
+    const GameState& gs;
+    const CheckInfo& ci;
+    Move hashmove;
+    Move killers[2];
+    bool hashmovePicked = false;
+    bool pseudoLegal = false; // the moves of 'ml' still need 'isLegal'
+    int killerIndex = 0;
+    Stage stage;
+    MoveList ml;
+    int cur = 0;
+};
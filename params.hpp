@@ -46,7 +46,24 @@ namespace azalea {
     constexpr int maxDepth = 100;
     constexpr int aspirationWindowSize = 520; // in millipawns
     constexpr int deltaMargin = 2000; // 2 pawns
-    constexpr int repHistMaxPly = 1024;
+    constexpr int maxPly = 128; // killer moves are kept up to this ply
+
+    /**************************************************************************
+     * Move ordering
+     *
+     * stagedMovePicker - hash move, captures, killers and quiets are generated
+     *                    and tried one stage after another if true, otherwise
+     *                    all moves are generated and sorted upfront
+     */
+    constexpr bool stagedMovePicker = true;
+
+    /**************************************************************************
+     * Make/unmake
+     *
+     * copyMake - search and perft copy the position before every move and
+     *            restore the copy instead of running 'unmakeMove' if true
+     */
+    constexpr bool copyMake = false;
 
     /**************************************************************************
      * Move generation
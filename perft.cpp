@@ -4,6 +4,7 @@
 #include "util.hpp"
 #include "zobrist.hpp"
 #include "fen.hpp"
+#include "magics.hpp"
 
 #include <vector>
 #include <iostream>
@@ -11,7 +12,7 @@
 
 void perftdiv(const GameState& gs, int depth, const zobristKeys& zobrist) {
     const auto start = std::chrono::high_resolution_clock::now();
-    std::vector<Move> ml;
+    MoveList ml;
     bool inCheck;
     generateLegalMoves(gs, ml, inCheck);
     unsigned long long int totnodes = 0;
@@ -31,21 +32,257 @@ void perftdiv(const GameState& gs, int depth, const zobristKeys& zobrist) {
 
 unsigned long long int perft(GameState& gs, int depth,
 						const zobristKeys& zobrist) {
+    // bulk counting, the moves of the last ply are never created
+    if (depth == 1) return (unsigned long long int)countLegalMoves(gs);
+
     unsigned long long int nodes = 0;
 
-    std::vector<Move> ml;
+    MoveList ml;
     bool inCheck;
     generateLegalMoves(gs, ml, inCheck);
-    const int nMoves = ml.size();
-
-    if (depth == 1) return (unsigned long long int)nMoves;
 
     for (const auto& m: ml) {
-	const auto umi = gs.makeMove(m, zobrist);
+	const auto umi = gs.doMove(m, zobrist);
 	nodes += perft(gs, depth-1, zobrist);
-	gs.unmakeMove(umi, zobrist);
+	gs.undoMove(umi);
     }
 
     return nodes;
 }
 
+
+// true if both positions are the same in every field
+static bool samePosition(const Position& a, const Position& b) {
+    for (int i=0; i<6; i++)
+	if (a.board.pieces[i] != b.board.pieces[i]) return false;
+    for (int sq=0; sq<64; sq++)
+	if (a.board.squares[sq] != b.board.squares[sq]) return false;
+    return a.board.colors[0] == b.board.colors[0]
+	and a.board.colors[1] == b.board.colors[1]
+	and a.board.occ == b.board.occ
+	and a.whiteToMove == b.whiteToMove
+	and a.whiteShort == b.whiteShort and a.whiteLong == b.whiteLong
+	and a.blackShort == b.blackShort and a.blackLong == b.blackLong
+	and a.halfmoveClock == b.halfmoveClock
+	and a.epTarget == b.epTarget
+	and a.zhash == b.zhash
+	and a.pawnKey == b.pawnKey and a.materialKey == b.materialKey
+	and a.earlySum == b.earlySum and a.lateSum == b.lateSum
+	and a.phase == b.phase;
+}
+
+static void nullMoveWalk(GameState& gs, int depth, const zobristKeys& zobrist,
+	unsigned long long int& nodes, unsigned long long int& errors) {
+    nodes++;
+
+    const Position before = gs;
+    const auto numi = gs.makeNullMove(zobrist);
+    if (gs.zhash != fen(toFen(gs), zobrist).zhash) {
+	if (errors++ == 0)
+	    std::cout << "hash mismatch after null move: " << toFen(gs) << "\n";
+    }
+    gs.unmakeNullMove(numi);
+    if (not samePosition(gs, before)) {
+	if (errors++ == 0)
+	    std::cout << "null move not restored: " << toFen(gs) << "\n";
+    }
+
+    if (depth == 0) return;
+
+    MoveList ml;
+    bool inCheck;
+    generateLegalMoves(gs, ml, inCheck);
+    for (const auto& m: ml) {
+	const auto umi = gs.makeMove(m, zobrist);
+	nullMoveWalk(gs, depth-1, zobrist, nodes, errors);
+	gs.unmakeMove(umi);
+    }
+}
+
+/******************************************************************************
+ * Consistency test of the null move: walks the tree like perft and at every
+ * node makes a null move, compares its incremental hash with the hash of the
+ * position read back from its FEN and checks that unmaking it restores the
+ * position exactly. Returns the number of errors.
+ */
+unsigned long long int nullMoveTest(GameState& gs, int depth,
+					const zobristKeys& zobrist) {
+    unsigned long long int nodes = 0;
+    unsigned long long int errors = 0;
+    nullMoveWalk(gs, depth, zobrist, nodes, errors);
+    std::cout << "nodes: " << nodes << " errors: " << errors << "\n";
+    return errors;
+}
+
+static void givesCheckWalk(GameState& gs, int depth,
+	const zobristKeys& zobrist, unsigned long long int& moves,
+	unsigned long long int& checks, unsigned long long int& errors) {
+    MoveList ml;
+    bool inCheck;
+    generateLegalMoves(gs, ml, inCheck);
+    const CheckSquares cs = computeCheckSquares(gs);
+    for (const auto& m: ml) {
+	const bool predicted = givesCheck(gs, cs, m);
+	const auto umi = gs.makeMove(m, zobrist);
+	const bool actual = (computeCheckers(gs) != 0x0ULL);
+	moves++;
+	if (actual) checks++;
+	if (predicted != actual) {
+	    gs.unmakeMove(umi);
+	    if (errors++ == 0)
+		std::cout << "givesCheck wrong for " << toString(m)
+			  << " in " << toFen(gs) << "\n";
+	    gs.makeMove(m, zobrist);
+	}
+	if (depth > 1) givesCheckWalk(gs, depth-1, zobrist, moves, checks,
+								    errors);
+	gs.unmakeMove(umi);
+    }
+}
+
+/******************************************************************************
+ * Consistency test of 'givesCheck': walks the perft tree of positions with
+ * direct, discovered, promotion, en passant and castling checks and compares
+ * the prediction for every legal move with the checkers after making it.
+ * Returns the number of errors.
+ */
+unsigned long long int givesCheckTest(const zobristKeys& zobrist) {
+    const std::vector<std::pair<std::string, int>> positions = {
+	// perft test positions
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	    3},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5},
+	{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3},
+	{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3},
+	// castling with check
+	{"5k2/8/8/8/8/8/8/R3K2R w KQ - 0 1", 3},
+	// en passant uncovering a rook check
+	{"8/8/8/8/r2Pp2K/8/8/k7 b - d3 0 1", 3},
+	// promotions with check
+	{"3k4/1P6/8/8/8/8/6p1/4K3 w - - 0 1", 3},
+	// discovered checks by a knight, a bishop and a pawn
+	{"4k3/8/8/4N3/8/2B5/3P4/4R1K1 w - - 0 1", 3},
+    };
+
+    unsigned long long int moves = 0;
+    unsigned long long int checks = 0;
+    unsigned long long int errors = 0;
+    for (const auto& [f, depth]: positions) {
+	GameState gs = fen(f, zobrist);
+	givesCheckWalk(gs, depth, zobrist, moves, checks, errors);
+    }
+    std::cout << "moves: " << moves << " checks: " << checks
+	      << " errors: " << errors << "\n";
+    return errors;
+}
+
+// perft over all positions, returns the nodes per second
+static unsigned long long int benchPositions(
+	const std::vector<std::pair<std::string, int>>& positions,
+	const zobristKeys& zobrist, unsigned long long int& totnodes) {
+    totnodes = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& [f, depth]: positions) {
+	GameState gs = fen(f, zobrist);
+	totnodes += perft(gs, depth, zobrist);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto duration
+	= std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    const auto ms = duration.count() + 1; // round up
+    return (totnodes*1000)/ms;
+}
+
+/******************************************************************************
+ * Microbenchmark of 'attackersTo': all attackers of every square of the given
+ * positions, once with the full occupancy and once more for every attacker
+ * removed (x-ray attackers as found by SEE). Returns the calls per second.
+ */
+static unsigned long long int benchAttackersTo(
+	const std::vector<std::pair<std::string, int>>& positions,
+	const zobristKeys& zobrist, unsigned long long int& calls) {
+    std::vector<Board> boards;
+    for (const auto& [f, depth]: positions)
+	boards.push_back(fen(f, zobrist).board);
+
+    calls = 0;
+    bitb checksum = 0x0ULL; // keeps the calls from being optimized away
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int rep=0; rep<20000; rep++) {
+	for (const auto& b: boards) {
+	    for (int sq=0; sq<64; sq++) {
+		bitb attackers = attackersTo(b, sq, b.occ);
+		calls++;
+		checksum ^= attackers;
+		while (attackers) {
+		    const bitb occ = b.occ ^ (attackers & -attackers);
+		    checksum ^= attackersTo(b, sq, occ);
+		    calls++;
+		    attackers &= attackers - 1;
+		}
+	    }
+	}
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto duration
+	= std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    const auto ms = duration.count() + 1; // round up
+    volatile bitb sink = checksum;
+    (void)sink;
+    return (calls*1000)/ms;
+}
+
+/******************************************************************************
+ * Runs perft on a fixed set of positions with every slider backend and every
+ * fill backend (king danger) available on this CPU and reports the nodes per
+ * second. The active backends are restored afterwards.
+ */
+void bench(const zobristKeys& zobrist) {
+    const std::vector<std::pair<std::string, int>> positions = {
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5},
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+									    5},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6},
+	{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+									    4},
+    };
+
+    const SliderBackend active = sliderBackend;
+    std::cout << "active slider backend: " << toString(active) << "\n";
+
+    std::vector<SliderBackend> backends = {SliderBackend::rays,
+					   SliderBackend::magic};
+    if (fastPext()) backends.push_back(SliderBackend::pext);
+
+    for (const auto backend: backends) {
+	sliderBackend = backend;
+	unsigned long long int totnodes;
+	const auto nps = benchPositions(positions, zobrist, totnodes);
+	std::cout << "  " << toString(backend) << ": nodes " << totnodes
+		  << " nps " << nps << "\n";
+    }
+    sliderBackend = active;
+
+    const FillBackend activeFill = fillBackend;
+    std::cout << "active fill backend: " << toString(activeFill) << "\n";
+
+    std::vector<FillBackend> fills = {FillBackend::lookup,
+				      FillBackend::scalar};
+    if (detectFillBackend() == FillBackend::avx2)
+	fills.push_back(FillBackend::avx2);
+
+    for (const auto backend: fills) {
+	fillBackend = backend;
+	unsigned long long int totnodes;
+	const auto nps = benchPositions(positions, zobrist, totnodes);
+	std::cout << "  " << toString(backend) << ": nodes " << totnodes
+		  << " nps " << nps << "\n";
+    }
+    fillBackend = activeFill;
+
+    unsigned long long int calls;
+    const auto cps = benchAttackersTo(positions, zobrist, calls);
+    std::cout << "attackersTo: calls " << calls << " per second " << cps
+									<< "\n";
+    std::cout << std::flush;
+}
@@ -3,6 +3,7 @@
 #include "board.hpp"
 #include "move.hpp"
 #include "movegenerator.hpp"
+#include "movepicker.hpp"
 #include "params.hpp"
 #include "eval.hpp"
 #include "statistics.hpp"
@@ -17,93 +18,77 @@ using namespace std::chrono;
 unsigned long long int nodes, qnodes, tthits;
 bool terminateSearch;
 
+// two killer moves per ply
+Move killers[azalea::maxPly][2];
+
+// hashes of the game before the root and of the current search path
+History history;
+
 extern int movetime;
 extern TTentry tTable[ttsize];
 
 constexpr int INF = std::numeric_limits<int>::max()-1;
 
-int qsearch(GameState& gs, int alpha, int beta, const zobristKeys& zobrist);
+int qsearch(GameState& gs, const bitb checkers, int alpha, int beta, int ply,
+						const zobristKeys& zobrist);
 int alphaBeta(GameState& gs, int beta, int alpha, int curDepth,
 	      int ply, const zobristKeys& zobrist);
 
-// checks for three-fold repetition
+// checks for three-fold repetition, for now a single earlier occurrence
+// already counts
 bool checkThreeFoldRep(const GameState& gs) {
-    int repetitions = 0;
-    for (int i=gs.repPlyCounter-1; i>=0 and i<azalea::repHistMaxPly; i--) {
-        if (gs.repHist[i] == gs.zhash) repetitions++;
-	if (repetitions == 1) { // for now
-	    return true;
-	}
-    }
-    return false;
+    return history.isRepetition(gs.zhash, gs.halfmoveClock);
 }
 
 // scores the moves given in the movelist
 constexpr int HASHSCORE = std::numeric_limits<int>::max();
-std::vector<int> scoreMoves(const GameState& gs, const std::vector<Move>& ml, const Move& hashmove) {
+void scoreMoves(const GameState& gs, MoveList& ml, const Move& hashmove) {
+    // piece values by piece type (none, pawn, ..., king), en passant
+    // captures find no piece on the to-square and count as capturing nothing
+    constexpr int value[7] = {0, 100, 300, 325, 500, 900, 1000};
     const auto& b = gs.board;
-    std::vector<int> scores;
-    for (const auto& m: ml) {
+    for (int i=0; i<ml.size(); i++) {
+	const auto& m = ml[i];
 	if (m == hashmove) {
-	    scores.push_back(HASHSCORE);
+	    ml.scores[i] = HASHSCORE;
 	    continue;
 	}
-	const auto fromMask = (1ULL << m.from);
-	const auto toMask = (1ULL << m.to);
-	if (m.capture and m.promo) {
-	    int score = 100000 - 100;
-	    if (m.promoPiece == 'q') { score += 900;
-	    } else if (m.promoPiece == 'r') { score += 500;
-	    } else if (m.promoPiece == 'b') { score += 325;
-	    } else if (m.promoPiece == 'n') { score += 300;
-	    }
-	    if (toMask & (b.wPawns | b.bPawns)) { score += 100;
-	    } else if (toMask & (b.wKnights | b.bKnights)) { score += 300;
-	    } else if (toMask & (b.wBishops | b.bBishops)) { score += 325;
-	    } else if (toMask & (b.wRooks | b.bRooks)) { score += 500;
-	    } else if (toMask & (b.wQueens | b.bQueens)) { score += 900;
-	    }
-	    scores.push_back(score);
-	} else if (m.capture) {
-	    int score = 100000;
-	    if (fromMask & (b.wPawns | b.bPawns)) { score -= 100;
-	    } else if (fromMask & (b.wKnights | b.bKnights)) { score -= 300;
-	    } else if (fromMask & (b.wBishops | b.bBishops)) { score -= 325;
-	    } else if (fromMask & (b.wRooks | b.bRooks)) { score -= 500;
-	    } else if (fromMask & (b.wQueens | b.bQueens)) { score -= 900;
-	    } else if (fromMask & (b.wKing | b.bKing)) { score -= 1000;
-	    }
-	    if (toMask & (b.wPawns | b.bPawns)) { score += 100;
-	    } else if (toMask & (b.wKnights | b.bKnights)) { score += 300;
-	    } else if (toMask & (b.wBishops | b.bBishops)) { score += 325;
-	    } else if (toMask & (b.wRooks | b.bRooks)) { score += 500;
-	    } else if (toMask & (b.wQueens | b.bQueens)) { score += 900;
+	const int victim = value[static_cast<int>(b.squares[m.to()])];
+	if (m.capture() and m.promo()) {
+	    int score = 100000 - 100 + victim;
+	    if (m.promoPiece() == 'q') { score += 900;
+	    } else if (m.promoPiece() == 'r') { score += 500;
+	    } else if (m.promoPiece() == 'b') { score += 325;
+	    } else if (m.promoPiece() == 'n') { score += 300;
 	    }
-	    scores.push_back(score);
-	} else if (m.promo) {
+	    ml.scores[i] = score;
+	} else if (m.capture()) {
+	    const int attacker = value[static_cast<int>(b.squares[m.from()])];
+	    ml.scores[i] = 100000 - attacker + victim;
+	} else if (m.promo()) {
 	    int score = 100000;
-	    if (m.promoPiece == 'q') { score += 900;
-	    } else if (m.promoPiece == 'r') { score += 500;
-	    } else if (m.promoPiece == 'b') { score += 325;
-	    } else if (m.promoPiece == 'n') { score += 300;
+	    if (m.promoPiece() == 'q') { score += 900;
+	    } else if (m.promoPiece() == 'r') { score += 500;
+	    } else if (m.promoPiece() == 'b') { score += 325;
+	    } else if (m.promoPiece() == 'n') { score += 300;
 	    }
-	    scores.push_back(score);
+	    ml.scores[i] = score;
 	} else {
-	    scores.push_back(0);
+	    ml.scores[i] = 0;
 	}
     }
-    return scores;
 }
 
 // insertion sort that sort up to a certain move
-void sortMove(std::vector<Move>& ml, std::vector<int>& scores, const int& n) {
+void sortMove(MoveList& ml, const int n) {
+    int* scores = ml.scores;
     // the first n moves are already
     // take first unsorted move a initial bestscore
     int bestscore = scores[n];
     int bestindex = n;
 
     // look for best move in unordered part
-    for (size_t i=n; i<ml.size(); i++) {
+    for (int i=n; i<ml.size(); i++) {
 	if (scores[i] > bestscore) {
 	    bestindex = i;
 	    bestscore = scores[i];
@@ -133,7 +118,8 @@ void sortMove(std::vector<Move>& ml, std::vector<int>& scores, const int& n) {
  * TODO add comment D:
  *
  */
-void search(GameState& gs, const int depth, const zobristKeys& zobrist) {
+void search(GameState& gs, const History& gameHistory, const int depth,
+					    const zobristKeys& zobrist) {
     ///////////////////////////////////////////////////////////////
     //                       INITIALIZATION                      //
     ///////////////////////////////////////////////////////////////
@@ -147,7 +133,12 @@ void search(GameState& gs, const int depth, const zobristKeys& zobrist) {
     nodes = 0;
     qnodes = 0;
     Move returnMove;
+    for (int i=0; i<azalea::maxPly; i++) {
+	killers[i][0] = Move();
+	killers[i][1] = Move();
+    }
     terminateSearch = false;
+    history = gameHistory;
     
     // add a small buffer to movetime so the engine doesnt timeout
     if (movetime > -1) movetime = std::max(1, movetime-30);
@@ -184,7 +175,7 @@ void search(GameState& gs, const int depth, const zobristKeys& zobrist) {
 	Move bestmove;
 	const int score = searchRoot(gs, alpha, beta, curDepth,
 				     zobrist, bestmove);
-	if (bestmove.to == 0 and bestmove.from == 0) break;
+	if (bestmove == Move()) break;
 	returnMove = bestmove;
 	if constexpr (azalea::statistics)
 	    outputStats("searchRoot returned score: "
@@ -295,7 +286,7 @@ int searchRoot(GameState& gs, int alpha, int beta,
     }
 
     // generate legal moves
-    std::vector<Move> movelist;
+    MoveList movelist;
     bool inCheck;
     generateLegalMoves(gs, movelist, inCheck);
 
@@ -323,13 +314,15 @@ int searchRoot(GameState& gs, int alpha, int beta,
     if (probeEntry.draft != -1) hashmove = probeEntry.bestmove;
 
     // move ordering
-    auto scores = scoreMoves(gs, movelist, hashmove);
-    sortMove(movelist, scores, 0);
+    scoreMoves(gs, movelist, hashmove);
+    sortMove(movelist, 0);
 
     // ================== PVS first move ==================
-    const auto umi = gs.makeMove(movelist[0], zobrist);
+    history.push(gs.zhash);
+    const auto umi = gs.doMove(movelist[0], zobrist);
     int score = -alphaBeta(gs, -beta, -alpha, curDepth-1, 1, zobrist);
-    gs.unmakeMove(umi, zobrist);
+    gs.undoMove(umi);
+    history.pop();
 
     if (terminateSearch) return bestscore;
 
@@ -351,11 +344,12 @@ int searchRoot(GameState& gs, int alpha, int beta,
 
 
     // iterate over legal moves
-    for (size_t n=1; n<movelist.size(); n++) {
-	sortMove(movelist, scores, n);
+    for (int n=1; n<movelist.size(); n++) {
+	sortMove(movelist, n);
 	const auto& m = movelist[n];
 
-	const auto umi = gs.makeMove(m, zobrist);
+	history.push(gs.zhash);
+	const auto umi = gs.doMove(m, zobrist);
 	int score = -alphaBeta(gs, -alpha-1, -alpha, curDepth-1, 1, zobrist);
 	if (score > alpha and score < beta) {
 	    // research needed, use full window
@@ -365,7 +359,8 @@ int searchRoot(GameState& gs, int alpha, int beta,
 		alpha = score;
 	    }
 	}
-	gs.unmakeMove(umi, zobrist);
+	gs.undoMove(umi);
+	history.pop();
 
 	if (terminateSearch) return bestscore;
 
@@ -427,16 +422,10 @@ int alphaBeta(GameState& gs, int alpha, int beta, int curDepth,
 	}
     }
 
-    // generate legal moves
-    std::vector<Move> movelist;
-    bool inCheck;
-    generateLegalMoves(gs, movelist, inCheck);
-
-    // check and stale mate detection
-    if (movelist.size() == 0) {
-        if (inCheck) return azalea::CHECKMATE + ply;
-	return 0;
-    }
+    // the checkers are all the extension and the horizon need, the pins are
+    // only computed once moves are searched here
+    const bitb checkers = computeCheckers(gs);
+    const bool inCheck = (checkers != 0x0ULL);
 
     // singular check extension
     if (inCheck) curDepth++;
@@ -469,60 +458,53 @@ int alphaBeta(GameState& gs, int alpha, int beta, int curDepth,
     }
 
     // enter quiescence search
-    if (curDepth <= 0) return qsearch(gs, alpha, beta, zobrist);
+    if (curDepth <= 0) {
+	// stale mate detection, never in check here due to the extension
+	if (countLegalMoves(gs) == 0) return 0;
+	return qsearch(gs, checkers, alpha, beta, ply, zobrist);
+    }
 
     nodes++;
     int bestscore = -INF;
     NodeType ttNode = NodeType::AlphaNode;
     Move bestmove;
 
-    // move ordering
-    auto scores = scoreMoves(gs, movelist, hashmove);
-    sortMove(movelist, scores, 0);
-
-
-    // ================== PVS first move ==================
-    const auto umi = gs.makeMove(movelist[0], zobrist);
-    const int score = -alphaBeta(gs, -beta, -alpha, curDepth-1, ply+1, zobrist);
-    gs.unmakeMove(umi, zobrist);
-
-    if (terminateSearch) return bestscore;
-
-    bestscore = score;
-    bestmove = movelist[0];
-
-    // beta cutoff
-    if (score >= beta) {
-	ttNode = NodeType::BetaNode;
-	goto saveTTAndReturn;
-    }
-
-    // raising alpha
-    if (score > alpha) {
-	ttNode = NodeType::PVNode;
-	alpha = score;
-    }
-    // ================== end of PVS first move ==================
+    // check and pin info, shared by the move picker and the legality tests
+    // (the moves are only generated once needed), the king danger is only
+    // computed if in check
+    const CheckInfo ci = computePinInfo(gs, checkers);
 
+    // moves are handed out one by one: hash move, captures, killers, quiets
+    // (or all evasions if in check)
+    MovePicker picker(gs, ci, hashmove,
+		      (ply < azalea::maxPly ? killers[ply] : nullptr));
+    int movesSearched = 0;
 
-    // iterate over remaining legal moves
-    for (size_t n=1; n<movelist.size(); n++) {
-	sortMove(movelist, scores, n);
-	const auto& m = movelist[n];
-	if (terminateSearch) return bestscore;
-
-	const auto umi = gs.makeMove(m, zobrist);
-	int score = -alphaBeta(gs, -alpha-1, -alpha,
-			       curDepth-1, ply+1, zobrist);
-	if (score > alpha and score < beta) {
-	    // research needed, use full window
+    // iterate over legal moves
+    Move m;
+    while (picker.next(m)) {
+	history.push(gs.zhash);
+	const auto umi = gs.doMove(m, zobrist);
+	int score;
+	if (movesSearched == 0) {
+	    // PVS first move, searched with the full window
 	    score = -alphaBeta(gs, -beta, -alpha, curDepth-1, ply+1, zobrist);
-	    if (score > alpha) {
-		ttNode = NodeType::PVNode;
-		alpha = score;
+	} else {
+	    score = -alphaBeta(gs, -alpha-1, -alpha,
+			       curDepth-1, ply+1, zobrist);
+	    if (score > alpha and score < beta) {
+		// research needed, use full window
+		score = -alphaBeta(gs, -beta, -alpha,
+				   curDepth-1, ply+1, zobrist);
+		if (score > alpha) {
+		    ttNode = NodeType::PVNode;
+		    alpha = score;
+		}
 	    }
 	}
-	gs.unmakeMove(umi, zobrist);
+	gs.undoMove(umi);
+	history.pop();
+	movesSearched++;
 
 	if (terminateSearch) return bestscore;
 
@@ -534,6 +516,12 @@ int alphaBeta(GameState& gs, int alpha, int beta, int curDepth,
 	// beta cutoff
 	if (score >= beta) {
 	    ttNode = NodeType::BetaNode;
+	    // quiet moves causing a cutoff are remembered as killers
+	    if (not m.capture() and not m.promo() and ply < azalea::maxPly
+		    and not (m == killers[ply][0])) {
+		killers[ply][1] = killers[ply][0];
+		killers[ply][0] = m;
+	    }
 	    break;
 	}
 
@@ -544,8 +532,13 @@ int alphaBeta(GameState& gs, int alpha, int beta, int curDepth,
 	}
     }
 
+    // check and stale mate detection
+    if (movesSearched == 0) {
+        if (inCheck) return azalea::CHECKMATE + ply;
+	return 0;
+    }
+
     // store search info in transposition table
-saveTTAndReturn:
     if (not terminateSearch) {
 	TTentry entry;
 	entry.zhash = gs.zhash;
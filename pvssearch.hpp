@@ -1,6 +1,7 @@
 #pragma once
 
 #include "board.hpp"
+#include "history.hpp"
 #include "move.hpp"
 #include "params.hpp"
 
@@ -25,5 +26,6 @@ inline auto measureTimeSinceStart() {
  * TODO add comment D:
  *
  */
-void search(GameState& gs, const int depth, const zobristKeys& zobrist);
+void search(GameState& gs, const History& gameHistory, const int depth,
+					    const zobristKeys& zobrist);
 
@@ -18,15 +18,22 @@ extern unsigned long long int qnodes;
 
 constexpr int INF = std::numeric_limits<int>::max()-1;
 
-std::vector<int> scoreMoves(const GameState& gs, const std::vector<Move>& ml, const Move& hashmove);
-void sortMove(std::vector<Move>& ml, std::vector<int>& scores, const int& n);
+void scoreMoves(const GameState& gs, MoveList& ml, const Move& hashmove);
+void sortMove(MoveList& ml, const int n);
 
 /******************************************************************************
  * Quiescence search
+ *
+ * Searches captures and queen promotions on top of the stand pat score. If the
+ * side to move is in check all evasions are searched instead. 'checkers' are
+ * the pieces giving check (see 'computeCheckers'), computed by the caller
+ * after its makeMove. The pins are only computed once the stand pat did not
+ * cut off, without check the captures are generated pseudo-legal and only
+ * tested for legality once they are tried.
  */
-int qsearch(GameState& gs, int alpha, int beta, const zobristKeys& zobrist) {
+int qsearch(GameState& gs, const bitb checkers, int alpha, int beta, int ply,
+						const zobristKeys& zobrist) {
     qnodes++;
-    int standpat = eval<false>(gs);
 
     if (qnodes%2048 == 0) {
 	if (movetime > 0) {
@@ -45,26 +52,36 @@ int qsearch(GameState& gs, int alpha, int beta, const zobristKeys& zobrist) {
 	}
     }
 
-    if (standpat >= beta) {
-	return beta;
-    }
-    if (alpha < standpat) {
-	alpha = standpat;
+    // no stand pat in check, all evasions are searched
+    if (not checkers) {
+	int standpat = eval<false>(gs);
+	if (standpat >= beta) {
+	    return beta;
+	}
+	if (alpha < standpat) {
+	    alpha = standpat;
+	}
     }
 
-    std::vector<Move> movelist;
-    bool inCheck;
-    generateLegalMoves(gs, movelist, inCheck);
+    const CheckInfo ci = computePinInfo(gs, checkers);
+    MoveList movelist;
+    if (checkers) {
+	generateEvasions(gs, ci, movelist);
+	if (movelist.size() == 0) return azalea::CHECKMATE + ply;
+    } else {
+	// only captures and queen promotions are searched
+	generatePseudoMoves<GenType::tactical>(gs, ci, movelist);
+    }
 
     // move ordering
     const Move dummove;
-    auto scores = scoreMoves(gs, movelist, dummove);
+    scoreMoves(gs, movelist, dummove);
     
-    for (size_t n=0; n<movelist.size(); n++) {
-	sortMove(movelist, scores, n);
+    for (int n=0; n<movelist.size(); n++) {
+	sortMove(movelist, n);
 	const auto& m = movelist[n];
-	if (!m.capture and !(m.promo and m.promoPiece=='q')) continue;
-	auto umi = gs.makeMove(m, zobrist);
+	if (not checkers and not isLegal(gs, ci, m)) continue;
+	auto umi = gs.doMove(m, zobrist);
 
 	/* delta pruning
     	int delta = 0;
@@ -76,13 +93,14 @@ int qsearch(GameState& gs, int alpha, int beta, const zobristKeys& zobrist) {
 	    case pieceType::queen: delta = 9000; break;
 	}
 	if (standpat+delta+azalea::deltaMargin < alpha and !umi.promotion) {
-	    gs.unmakeMove(umi, zobrist);
+	    gs.undoMove(umi);
 	    continue;
 	}
     	// end of delta pruning */
 
-	int score = -qsearch(gs, -beta, -alpha, zobrist);
-	gs.unmakeMove(umi, zobrist);
+	int score = -qsearch(gs, computeCheckers(gs), -beta, -alpha, ply+1,
+								zobrist);
+	gs.undoMove(umi);
 
 	if (terminateSearch) break;
 
@@ -1,539 +1,77 @@
 #pragma once
 
-constexpr uint64_t nRays[64] = {
-0x101010101010100,
-0x202020202020200,
-0x404040404040400,
-0x808080808080800,
-0x1010101010101000,
-0x2020202020202000,
-0x4040404040404000,
-0x8080808080808000,
-0x101010101010000,
-0x202020202020000,
-0x404040404040000,
-0x808080808080000,
-0x1010101010100000,
-0x2020202020200000,
-0x4040404040400000,
-0x8080808080800000,
-0x101010101000000,
-0x202020202000000,
-0x404040404000000,
-0x808080808000000,
-0x1010101010000000,
-0x2020202020000000,
-0x4040404040000000,
-0x8080808080000000,
-0x101010100000000,
-0x202020200000000,
-0x404040400000000,
-0x808080800000000,
-0x1010101000000000,
-0x2020202000000000,
-0x4040404000000000,
-0x8080808000000000,
-0x101010000000000,
-0x202020000000000,
-0x404040000000000,
-0x808080000000000,
-0x1010100000000000,
-0x2020200000000000,
-0x4040400000000000,
-0x8080800000000000,
-0x101000000000000,
-0x202000000000000,
-0x404000000000000,
-0x808000000000000,
-0x1010000000000000,
-0x2020000000000000,
-0x4040000000000000,
-0x8080000000000000,
-0x100000000000000,
-0x200000000000000,
-0x400000000000000,
-0x800000000000000,
-0x1000000000000000,
-0x2000000000000000,
-0x4000000000000000,
-0x8000000000000000,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-};
+#include <array>
+#include <cstdint>
 
-constexpr uint64_t sRays[64] = {
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x1,
-0x2,
-0x4,
-0x8,
-0x10,
-0x20,
-0x40,
-0x80,
-0x101,
-0x202,
-0x404,
-0x808,
-0x1010,
-0x2020,
-0x4040,
-0x8080,
-0x10101,
-0x20202,
-0x40404,
-0x80808,
-0x101010,
-0x202020,
-0x404040,
-0x808080,
-0x1010101,
-0x2020202,
-0x4040404,
-0x8080808,
-0x10101010,
-0x20202020,
-0x40404040,
-0x80808080,
-0x101010101,
-0x202020202,
-0x404040404,
-0x808080808,
-0x1010101010,
-0x2020202020,
-0x4040404040,
-0x8080808080,
-0x10101010101,
-0x20202020202,
-0x40404040404,
-0x80808080808,
-0x101010101010,
-0x202020202020,
-0x404040404040,
-0x808080808080,
-0x1010101010101,
-0x2020202020202,
-0x4040404040404,
-0x8080808080808,
-0x10101010101010,
-0x20202020202020,
-0x40404040404040,
-0x80808080808080,
-};
+/******************************************************************************
+ * Ray lookup tables, generated at compile time.
+ *
+ * Squares are counted from h1 (0) to a8 (63): a step to the west adds one, a
+ * step to the north adds eight. A ray starts next to its square and runs up to
+ * the edge of the board.
+ */
 
-constexpr uint64_t wRays[64] = {
-0xfe,
-0xfc,
-0xf8,
-0xf0,
-0xe0,
-0xc0,
-0x80,
-0x0,
-0xfe00,
-0xfc00,
-0xf800,
-0xf000,
-0xe000,
-0xc000,
-0x8000,
-0x0,
-0xfe0000,
-0xfc0000,
-0xf80000,
-0xf00000,
-0xe00000,
-0xc00000,
-0x800000,
-0x0,
-0xfe000000,
-0xfc000000,
-0xf8000000,
-0xf0000000,
-0xe0000000,
-0xc0000000,
-0x80000000,
-0x0,
-0xfe00000000,
-0xfc00000000,
-0xf800000000,
-0xf000000000,
-0xe000000000,
-0xc000000000,
-0x8000000000,
-0x0,
-0xfe0000000000,
-0xfc0000000000,
-0xf80000000000,
-0xf00000000000,
-0xe00000000000,
-0xc00000000000,
-0x800000000000,
-0x0,
-0xfe000000000000,
-0xfc000000000000,
-0xf8000000000000,
-0xf0000000000000,
-0xe0000000000000,
-0xc0000000000000,
-0x80000000000000,
-0x0,
-0xfe00000000000000,
-0xfc00000000000000,
-0xf800000000000000,
-0xf000000000000000,
-0xe000000000000000,
-0xc000000000000000,
-0x8000000000000000,
-0x0,
-};
+// all squares reached from 'sq' by repeated steps of 'dRank' ranks and
+// 'dFile' files (positive towards the 8th rank and the a-file)
+constexpr uint64_t makeRay(const int sq, const int dRank, const int dFile) {
+    uint64_t ray = 0;
+    int rank = sq / 8 + dRank;
+    int file = sq % 8 + dFile;
+    while (rank >= 0 and rank < 8 and file >= 0 and file < 8) {
+	ray |= (1ULL << (8*rank + file));
+	rank += dRank;
+	file += dFile;
+    }
+    return ray;
+}
 
-constexpr uint64_t eRays[64] = {
-0x0,
-0x1,
-0x3,
-0x7,
-0xf,
-0x1f,
-0x3f,
-0x7f,
-0x0,
-0x100,
-0x300,
-0x700,
-0xf00,
-0x1f00,
-0x3f00,
-0x7f00,
-0x0,
-0x10000,
-0x30000,
-0x70000,
-0xf0000,
-0x1f0000,
-0x3f0000,
-0x7f0000,
-0x0,
-0x1000000,
-0x3000000,
-0x7000000,
-0xf000000,
-0x1f000000,
-0x3f000000,
-0x7f000000,
-0x0,
-0x100000000,
-0x300000000,
-0x700000000,
-0xf00000000,
-0x1f00000000,
-0x3f00000000,
-0x7f00000000,
-0x0,
-0x10000000000,
-0x30000000000,
-0x70000000000,
-0xf0000000000,
-0x1f0000000000,
-0x3f0000000000,
-0x7f0000000000,
-0x0,
-0x1000000000000,
-0x3000000000000,
-0x7000000000000,
-0xf000000000000,
-0x1f000000000000,
-0x3f000000000000,
-0x7f000000000000,
-0x0,
-0x100000000000000,
-0x300000000000000,
-0x700000000000000,
-0xf00000000000000,
-0x1f00000000000000,
-0x3f00000000000000,
-0x7f00000000000000,
-};
+constexpr std::array<uint64_t, 64> makeRayTable(const int dRank,
+							const int dFile) {
+    std::array<uint64_t, 64> table{};
+    for (int sq=0; sq<64; sq++) table[sq] = makeRay(sq, dRank, dFile);
+    return table;
+}
 
-constexpr uint64_t nwRays[64] = {
-0x8040201008040200,
-0x80402010080400,
-0x804020100800,
-0x8040201000,
-0x80402000,
-0x804000,
-0x8000,
-0x0,
-0x4020100804020000,
-0x8040201008040000,
-0x80402010080000,
-0x804020100000,
-0x8040200000,
-0x80400000,
-0x800000,
-0x0,
-0x2010080402000000,
-0x4020100804000000,
-0x8040201008000000,
-0x80402010000000,
-0x804020000000,
-0x8040000000,
-0x80000000,
-0x0,
-0x1008040200000000,
-0x2010080400000000,
-0x4020100800000000,
-0x8040201000000000,
-0x80402000000000,
-0x804000000000,
-0x8000000000,
-0x0,
-0x804020000000000,
-0x1008040000000000,
-0x2010080000000000,
-0x4020100000000000,
-0x8040200000000000,
-0x80400000000000,
-0x800000000000,
-0x0,
-0x402000000000000,
-0x804000000000000,
-0x1008000000000000,
-0x2010000000000000,
-0x4020000000000000,
-0x8040000000000000,
-0x80000000000000,
-0x0,
-0x200000000000000,
-0x400000000000000,
-0x800000000000000,
-0x1000000000000000,
-0x2000000000000000,
-0x4000000000000000,
-0x8000000000000000,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-};
+constexpr auto nRays = makeRayTable(1, 0);
+constexpr auto sRays = makeRayTable(-1, 0);
+constexpr auto wRays = makeRayTable(0, 1);
+constexpr auto eRays = makeRayTable(0, -1);
+constexpr auto nwRays = makeRayTable(1, 1);
+constexpr auto neRays = makeRayTable(1, -1);
+constexpr auto seRays = makeRayTable(-1, -1);
+constexpr auto swRays = makeRayTable(-1, 1);
 
-constexpr uint64_t neRays[64] = {
-0x0,
-0x100,
-0x10200,
-0x1020400,
-0x102040800,
-0x10204081000,
-0x1020408102000,
-0x102040810204000,
-0x0,
-0x10000,
-0x1020000,
-0x102040000,
-0x10204080000,
-0x1020408100000,
-0x102040810200000,
-0x204081020400000,
-0x0,
-0x1000000,
-0x102000000,
-0x10204000000,
-0x1020408000000,
-0x102040810000000,
-0x204081020000000,
-0x408102040000000,
-0x0,
-0x100000000,
-0x10200000000,
-0x1020400000000,
-0x102040800000000,
-0x204081000000000,
-0x408102000000000,
-0x810204000000000,
-0x0,
-0x10000000000,
-0x1020000000000,
-0x102040000000000,
-0x204080000000000,
-0x408100000000000,
-0x810200000000000,
-0x1020400000000000,
-0x0,
-0x1000000000000,
-0x102000000000000,
-0x204000000000000,
-0x408000000000000,
-0x810000000000000,
-0x1020000000000000,
-0x2040000000000000,
-0x0,
-0x100000000000000,
-0x200000000000000,
-0x400000000000000,
-0x800000000000000,
-0x1000000000000000,
-0x2000000000000000,
-0x4000000000000000,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-};
-
-constexpr uint64_t seRays[64] = {
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x1,
-0x2,
-0x4,
-0x8,
-0x10,
-0x20,
-0x40,
-0x0,
-0x100,
-0x201,
-0x402,
-0x804,
-0x1008,
-0x2010,
-0x4020,
-0x0,
-0x10000,
-0x20100,
-0x40201,
-0x80402,
-0x100804,
-0x201008,
-0x402010,
-0x0,
-0x1000000,
-0x2010000,
-0x4020100,
-0x8040201,
-0x10080402,
-0x20100804,
-0x40201008,
-0x0,
-0x100000000,
-0x201000000,
-0x402010000,
-0x804020100,
-0x1008040201,
-0x2010080402,
-0x4020100804,
-0x0,
-0x10000000000,
-0x20100000000,
-0x40201000000,
-0x80402010000,
-0x100804020100,
-0x201008040201,
-0x402010080402,
-0x0,
-0x1000000000000,
-0x2010000000000,
-0x4020100000000,
-0x8040201000000,
-0x10080402010000,
-0x20100804020100,
-0x40201008040201,
-};
-
-constexpr uint64_t swRays[64] = {
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x0,
-0x2,
-0x4,
-0x8,
-0x10,
-0x20,
-0x40,
-0x80,
-0x0,
-0x204,
-0x408,
-0x810,
-0x1020,
-0x2040,
-0x4080,
-0x8000,
-0x0,
-0x20408,
-0x40810,
-0x81020,
-0x102040,
-0x204080,
-0x408000,
-0x800000,
-0x0,
-0x2040810,
-0x4081020,
-0x8102040,
-0x10204080,
-0x20408000,
-0x40800000,
-0x80000000,
-0x0,
-0x204081020,
-0x408102040,
-0x810204080,
-0x1020408000,
-0x2040800000,
-0x4080000000,
-0x8000000000,
-0x0,
-0x20408102040,
-0x40810204080,
-0x81020408000,
-0x102040800000,
-0x204080000000,
-0x408000000000,
-0x800000000000,
-0x0,
-0x2040810204080,
-0x4081020408000,
-0x8102040800000,
-0x10204080000000,
-0x20408000000000,
-0x40800000000000,
-0x80000000000000,
-0x0,
-};
+/******************************************************************************
+ * Square to square tables, both are empty if the squares share no line.
+ *
+ * between[a][b] - the squares strictly between 'a' and 'b'
+ * line[a][b]    - the whole line through 'a' and 'b', edge to edge
+ */
+typedef std::array<std::array<uint64_t, 64>, 64> SquarePairTable;
 
+constexpr SquarePairTable makeSquarePairTable(const bool wholeLine) {
+    constexpr int directions[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+				       {1, 1}, {1, -1}, {-1, -1}, {-1, 1} };
+    SquarePairTable table{};
+    for (int from=0; from<64; from++) {
+	for (const auto& [dRank, dFile]: directions) {
+	    const uint64_t fullLine = makeRay(from, dRank, dFile)
+				    | makeRay(from, -dRank, -dFile)
+				    | (1ULL << from);
+	    uint64_t path = 0;
+	    int rank = from / 8 + dRank;
+	    int file = from % 8 + dFile;
+	    while (rank >= 0 and rank < 8 and file >= 0 and file < 8) {
+		const int to = 8*rank + file;
+		table[from][to] = (wholeLine ? fullLine : path);
+		path |= (1ULL << to);
+		rank += dRank;
+		file += dFile;
+	    }
+	}
+    }
+    return table;
+}
 
+inline constexpr SquarePairTable between = makeSquarePairTable(false);
+inline constexpr SquarePairTable line = makeSquarePairTable(true);
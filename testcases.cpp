@@ -86,21 +86,21 @@ void runTests() {
     for (const auto& m: ml) {
 	const auto umi = gscopy.makeMove(m);
 	gscopy.unmakeMove(umi);
-	if (gscopy.board.wPawns == gs.board.wPawns) passedMakeUnmake++;
+	if (gscopy.board.wPawns() == gs.board.wPawns()) passedMakeUnmake++;
 	else {std::cout << "   wPawns failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.bPawns == gs.board.bPawns) passedMakeUnmake++;
+	if (gscopy.board.bPawns() == gs.board.bPawns()) passedMakeUnmake++;
 	else {std::cout << "   bPawns failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.wKnights == gs.board.wKnights) passedMakeUnmake++;
+	if (gscopy.board.wKnights() == gs.board.wKnights()) passedMakeUnmake++;
 	else {std::cout << "   wKnights failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.bKnights == gs.board.bKnights) passedMakeUnmake++;
+	if (gscopy.board.bKnights() == gs.board.bKnights()) passedMakeUnmake++;
 	else {std::cout << "   bKnights failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.wBishops == gs.board.wBishops) passedMakeUnmake++;
+	if (gscopy.board.wBishops() == gs.board.wBishops()) passedMakeUnmake++;
 	else {std::cout << "   wBishops failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.bBishops == gs.board.bBishops) passedMakeUnmake++;
+	if (gscopy.board.bBishops() == gs.board.bBishops()) passedMakeUnmake++;
 	else {std::cout << "   bBishops failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.wRooks == gs.board.wRooks) passedMakeUnmake++;
+	if (gscopy.board.wRooks() == gs.board.wRooks()) passedMakeUnmake++;
 	else {std::cout << "   wRooks failed!\n"; failedMakeUnmake++;}
-	if (gscopy.board.bRooks == gs.board.bRooks) passedMakeUnmake++;
+	if (gscopy.board.bRooks() == gs.board.bRooks()) passedMakeUnmake++;
 	else {std::cout << "   bRooks failed!\n"; failedMakeUnmake++;}
     }
 
@@ -40,9 +40,9 @@ std::string_view toString(int index) {
  */
 std::string toString(const Move& m) {
     std::string alg = "";
-    alg += toString(m.from);
-    alg += toString(m.to);
-    if (m.promoPiece != ' ') alg += m.promoPiece;
+    alg += toString(m.from());
+    alg += toString(m.to());
+    if (m.promoPiece() != ' ') alg += m.promoPiece();
     return alg;
 }
 
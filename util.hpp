@@ -19,7 +19,7 @@ int toIndex(std::string s);
  * Calculate file from index a-file -> 0, b-file -> 1, ...
  */
 inline int fileOf(int index) {
-    return 8 - index%8;
+    return 7 - index%8;
 }
 
 /******************************************************************************
@@ -37,6 +37,15 @@ zobristKeys initZobrist() {
     // eight for en passant file
     for (int i=0; i<8; i++) zobrist.epFile[i] = gen64();
 
+    // material keys, one per possible count of each piece for each color
+    for (int c=0; c<2; c++) {
+	for (int i=0; i<6; i++) {
+	    for (int n=0; n<64; n++) {
+		zobrist.material[c][i][n] = gen64();
+	    }
+	}
+    }
+
     return zobrist;
 }
 
@@ -7,6 +7,9 @@ struct zobristKeys {
     uint64_t sideToMove; // set if black to move
     uint64_t castling[4]; // w short, w long, b short, b long
     uint64_t epFile[8];
+    // by color, piece type and number of pieces of that kind before it, the
+    // material key of a position is the XOR of all keys below the counts
+    uint64_t material[2][6][64];
 };
 void checkLinearIndependence(const int n, const zobristKeys z);
 zobristKeys initZobrist();